@@ -0,0 +1,165 @@
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+/*
+ * This file is part of the Vector3D distribution (https://github.com/cdelv/Vector3D).
+ * Copyright (c) 2022 Carlos Andres del Valle.
+ *
+ * Vector3D is under the terms of the BSD-3 license. We welcome feedback and contributions.
+ *
+ * you should have received a copy of the BSD3 Public License
+ * along with this program. If not, see <https://github.com/cdelv/Vector3D> LICENSE.
+ *
+ *
+ * This library requires C++20.
+*/
+
+/*
+*  Benchmark baselines. A baseline keeps the trial samples of every benchmark of a run, so that a later
+*  run, for example after changing vector.h, can be compared against it. A benchmark is a regression
+*  when its median time grew by more than a threshold and a Mann-Whitney U test says the two samples
+*  differ. The test is on ranks, so a few trials disturbed by the system do not decide it.
+*/
+namespace bench {
+
+// The samples of one benchmark, in nanoseconds per element
+struct Record {
+	std::string name;
+	std::string variant;
+	std::size_t bytes = 0;
+	std::size_t n = 0;
+	std::vector<double> samples;
+};
+
+// One line per benchmark with tab separated fields, since names have spaces and commas
+inline void save_baseline(const std::string& path, const std::vector<Record>& records) {
+	std::ofstream file(path);
+	if (!file)
+		throw std::runtime_error("bench: cannot open " + path);
+	file << "# Vector3D benchmark baseline 1\n"
+	     << "# name, variant, working set in bytes, elements, samples in ns/element\n"
+	     << std::setprecision(std::numeric_limits<double>::max_digits10);
+	for (const Record& r : records) {
+		file << r.name << '\t' << r.variant << '\t' << r.bytes << '\t' << r.n;
+		for (const double s : r.samples) file << '\t' << s;
+		file << '\n';
+	}
+	if (!file)
+		throw std::runtime_error("bench: cannot write " + path);
+}
+inline std::vector<Record> load_baseline(const std::string& path) {
+	std::ifstream file(path);
+	if (!file)
+		throw std::runtime_error("bench: cannot open " + path);
+	std::string line;
+	if (!std::getline(file, line) || line != "# Vector3D benchmark baseline 1")
+		throw std::runtime_error("bench: " + path + " is not a benchmark baseline");
+	std::vector<Record> records;
+	for (std::size_t number = 2; std::getline(file, line); ++number) {
+		if (line.empty() || line[0] == '#') continue;
+		std::vector<std::string> fields;
+		std::istringstream ls(line);
+		for (std::string f; std::getline(ls, f, '\t');) fields.push_back(f);
+		Record r;
+		try {
+			if (fields.size() < 5) throw std::invalid_argument("too few fields");
+			r.name = fields[0];
+			r.variant = fields[1];
+			r.bytes = std::stoul(fields[2]);
+			r.n = std::stoul(fields[3]);
+			for (std::size_t i = 4; i < fields.size(); ++i) r.samples.push_back(std::stod(fields[i]));
+		}
+		catch (const std::logic_error&) {
+			throw std::runtime_error("bench: bad line " + std::to_string(number) + " in " + path);
+		}
+		records.push_back(std::move(r));
+	}
+	return records;
+}
+
+// Two sided p-value of the Mann-Whitney U test of a and b coming from the same distribution. It uses
+// the normal approximation with the tie correction, which is good from about 8 samples on each side.
+inline double mann_whitney(const std::vector<double>& a, const std::vector<double>& b) {
+	const double n1 = a.size(), n2 = b.size(), n = n1 + n2;
+	if (a.empty() || b.empty()) return 1;
+	std::vector<std::pair<double, bool>> all; // value, from a
+	for (const double x : a) all.emplace_back(x, true);
+	for (const double x : b) all.emplace_back(x, false);
+	std::sort(all.begin(), all.end());
+	// Ties share the mean of their ranks
+	double rank_a = 0, ties = 0;
+	for (std::size_t i = 0; i < all.size();) {
+		std::size_t j = i;
+		while (j < all.size() && all[j].first == all[i].first) ++j;
+		const double t = j - i, rank = (i + j + 1) / 2.0;
+		for (std::size_t k = i; k < j; ++k)
+			if (all[k].second) rank_a += rank;
+		ties += t * t * t - t;
+		i = j;
+	}
+	const double u = rank_a - n1 * (n1 + 1) / 2;
+	const double variance = n1 * n2 / 12 * ((n + 1) - ties / (n * (n - 1)));
+	if (variance <= 0) return 1;
+	// With the continuity correction
+	const double z = std::max(std::abs(u - n1 * n2 / 2) - 0.5, 0.0) / std::sqrt(variance);
+	return std::erfc(z / std::sqrt(2.0));
+}
+
+// How one benchmark moved with respect to the baseline
+struct Comparison {
+	enum verdict { unchanged, faster, slower, added };
+	std::string name;
+	std::string variant;
+	std::size_t bytes = 0;
+	double baseline = 0;   // median ns/element
+	double current = 0;
+	double change = 0;     // relative change of the median time, positive is slower
+	double p = 1;
+	verdict result = added;
+};
+inline const char* verdict_name(const Comparison::verdict v) {
+	static constexpr const char* names[] = {"unchanged", "faster", "SLOWER", "not in baseline"};
+	return names[v];
+}
+// threshold is the relative change of the median below which nothing is reported, alpha the significance level
+inline std::vector<Comparison> compare(const std::vector<Record>& baseline, const std::vector<Record>& current,
+                                       const double threshold, const double alpha) {
+	const auto median = [](std::vector<double> s) {
+		if (s.empty()) return 0.0;
+		std::sort(s.begin(), s.end());
+		const std::size_t h = s.size() / 2;
+		return s.size() % 2 ? s[h] : (s[h - 1] + s[h]) / 2;
+	};
+	std::vector<Comparison> comparisons;
+	for (const Record& r : current) {
+		Comparison c;
+		c.name = r.name;
+		c.variant = r.variant;
+		c.bytes = r.bytes;
+		c.current = median(r.samples);
+		const auto old = std::find_if(baseline.begin(), baseline.end(), [&](const Record& b) {
+			return b.name == r.name && b.variant == r.variant && b.bytes == r.bytes;
+		});
+		if (old != baseline.end() && !old->samples.empty()) {
+			c.baseline = median(old->samples);
+			c.change = c.baseline > 0 ? c.current / c.baseline - 1 : 0;
+			c.p = mann_whitney(old->samples, r.samples);
+			c.result = Comparison::unchanged;
+			if (c.p < alpha && c.change > threshold) c.result = Comparison::slower;
+			else if (c.p < alpha && c.change < -threshold) c.result = Comparison::faster;
+		}
+		comparisons.push_back(std::move(c));
+	}
+	return comparisons;
+}
+
+}
@@ -0,0 +1,64 @@
+#if defined(VECTOR3D_MODULE)
+import vector3d;
+#else
+#include "../vector.h"
+#endif
+
+/*
+ * This file is part of the Vector3D distribution (https://github.com/cdelv/Vector3D).
+ * Copyright (c) 2022 Carlos Andres del Valle.
+ *
+ * Vector3D is under the terms of the BSD-3 license. We welcome feedback and contributions.
+ *
+ * you should have received a copy of the BSD3 Public License
+ * along with this program. If not, see <https://github.com/cdelv/Vector3D> LICENSE.
+ *
+ *
+ * This library requires C++20.
+*/
+
+/*
+*  Translation unit of the compile time benchmark (compile_time.sh). It includes vector.h, or imports
+*  the vector3d module when built with -DVECTOR3D_MODULE, and instantiates expressions up to DEPTH
+*  operations deep for several vector types. It has no other include, so both builds compile the
+*  same code and the difference is the cost of the header.
+*/
+
+#ifndef DEPTH
+#define DEPTH 16
+#endif
+
+// An expression D operations deep, with a new type on every level. The nodes reference the temporaries
+// of the levels above, which live until the end of the full expression, where it is evaluated.
+template <int D, typename E, typename V>
+V nest(const E &e, const V &a) {
+    if constexpr (D == 0)
+        return V(e);
+    else if constexpr (D % 4 == 0)
+        return nest<D - 1>(e + a, a);
+    else if constexpr (D % 4 == 1)
+        return nest<D - 1>(e - a[0] * a, a);
+    else if constexpr (D % 4 == 2)
+        return nest<D - 1>(ElemProd(e, a) / a[1], a);
+    else
+        return nest<D - 1>(a - e, a);
+}
+// All the depths from D down to 1, for one type
+template <typename V, int D>
+double depths(const V &a, const V &b) {
+    if constexpr (D == 0)
+        return 0;
+    else
+        return norm(nest<D>(b, a)) + depths<V, D - 1>(a, b);
+}
+
+int main() {
+    double s = 0;
+    s += depths<vector3D<double>, DEPTH>(vector3D<double>(1, 2, 3), vector3D<double>(3, 2, 1));
+    s += depths<vector3D<float>, DEPTH>(vector3D<float>(1, 2, 3), vector3D<float>(3, 2, 1));
+    s += depths<vector2D<double>, DEPTH>(vector2D<double>(1, 2), vector2D<double>(2, 1));
+    s += depths<vector2D<float>, DEPTH>(vector2D<float>(1, 2), vector2D<float>(2, 1));
+    s += depths<vectorND<double, 4>, DEPTH>(vectorND<double, 4>(1, 2, 3, 4), vectorND<double, 4>(4, 3, 2, 1));
+    s += depths<vectorND<float, 8>, DEPTH>(vectorND<float, 8>(1.0f), vectorND<float, 8>(2.0f));
+    return s > 0 ? 0 : 1;
+}
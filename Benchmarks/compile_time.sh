@@ -0,0 +1,48 @@
+#!/bin/sh
+#
+# This file is part of the Vector3D distribution (https://github.com/cdelv/Vector3D).
+# Copyright (c) 2022 Carlos Andres del Valle.
+#
+# Vector3D is under the terms of the BSD-3 license. We welcome feedback and contributions.
+#
+# You should have received a copy of the BSD3 Public License
+# along with this program. If not, see <https://github.com/cdelv/Vector3D> LICENSE.
+#
+# Compile time of Benchmarks/compile_time.cpp, including vector.h or importing the vector3d module,
+# with no expressions and with expressions up to DEPTH operations deep. It times the front end only
+# (-fsyntax-only): parsing and template instantiation, which is where the two differ. Each time is
+# the median of RUNS compilations. Run it from the root of the repository, after building the module.
+#
+# Usage: DEPTH=32 RUNS=5 sh Benchmarks/compile_time.sh
+set -e
+CXX=${CXX:-g++}
+DEPTH=${DEPTH:-24}
+RUNS=${RUNS:-5}
+SOURCE=Benchmarks/compile_time.cpp
+
+if [ ! -f gcm.cache/vector3d.gcm ]; then
+	echo "Build the module first: make vector3d.o" >&2
+	exit 1
+fi
+
+# Median wall time of RUNS runs of the command, in seconds
+median() {
+	i=0
+	while [ $i -lt "$RUNS" ]; do
+		start=$(date +%s.%N)
+		"$@"
+		end=$(date +%s.%N)
+		awk "BEGIN { print $end - $start }"
+		i=$((i + 1))
+	done | sort -n | awk '{ t[NR] = $1 } END { m = NR % 2 ? t[(NR + 1) / 2] : (t[NR / 2] + t[NR / 2 + 1]) / 2; printf "%.3f", m }'
+}
+
+printf " %-24s| %-9s| %-9s| \n" "Translation unit" "header" "module"
+echo "-------------------------------------------------|"
+for depth in 0 "$DEPTH"; do
+	header=$(median $CXX -std=c++20 -fsyntax-only -DDEPTH="$depth" $SOURCE)
+	module=$(median $CXX -std=c++20 -fmodules-ts -fsyntax-only -DVECTOR3D_MODULE -DDEPTH="$depth" $SOURCE)
+	printf " %-24s| %-9s| %-9s| \n" "depth $depth" "$header s" "$module s"
+done
+echo "-------------------------------------------------|"
+echo "( Median of $RUNS compilations with $($CXX --version | head -n 1) )"
@@ -0,0 +1,171 @@
+#pragma once
+#include <array>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#if defined(__linux__) && __has_include(<linux/perf_event.h>)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#define BENCH_PERF_EVENTS 1
+#endif
+#if defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>
+#endif
+
+/*
+ * This file is part of the Vector3D distribution (https://github.com/cdelv/Vector3D).
+ * Copyright (c) 2022 Carlos Andres del Valle.
+ *
+ * Vector3D is under the terms of the BSD-3 license. We welcome feedback and contributions.
+ *
+ * you should have received a copy of the BSD3 Public License
+ * along with this program. If not, see <https://github.com/cdelv/Vector3D> LICENSE.
+ *
+ *
+ * This library requires C++20.
+*/
+
+/*
+*  Hardware performance counters with Linux perf_event_open. Each counter is opened on its own, for
+*  the calling thread and user space only, so any of them can be missing: not Linux, no PMU in a
+*  virtual machine, kernel.perf_event_paranoid too high, or an event this CPU does not have. The
+*  missing ones are reported as unavailable and everything else keeps working.
+*/
+namespace bench {
+
+enum counter { cycles, instructions, l1d_misses, llc_misses, branch_misses, fp_vector, fp_scalar, counter_count };
+inline const char* counter_name(const counter c) {
+	static constexpr const char* names[counter_count] = {
+		"cycles", "instructions", "l1d_misses", "llc_misses", "branch_misses", "fp_vector", "fp_scalar"};
+	return names[c];
+}
+
+// Counts of one measurement. valid[c] is false for the counters that could not be read.
+struct CounterSample {
+	std::array<double, counter_count> value{};
+	std::array<bool, counter_count> valid{};
+	bool any() const {
+		for (const bool v : valid)
+			if (v) return true;
+		return false;
+	}
+	// Instructions per cycle, 0 if either is missing
+	double ipc() const {
+		return valid[cycles] && valid[instructions] && value[cycles] > 0 ? value[instructions] / value[cycles] : 0;
+	}
+	CounterSample& operator/=(const double d) {
+		for (double& v : value) v /= d;
+		return *this;
+	}
+};
+
+class Counters {
+	std::array<int, counter_count> _fd;
+	std::string _status = "not opened";
+
+#if defined(BENCH_PERF_EVENTS)
+	static bool intel() {
+#if defined(__x86_64__) || defined(__i386__)
+		unsigned a, b, c, d;
+		if (!__get_cpuid(0, &a, &b, &c, &d)) return false;
+		return b == 0x756e6547 && d == 0x49656e69 && c == 0x6c65746e; // "GenuineIntel"
+#else
+		return false;
+#endif
+	}
+	static int open(const std::uint32_t type, const std::uint64_t config) {
+		perf_event_attr attr;
+		std::memset(&attr, 0, sizeof(attr));
+		attr.size = sizeof(attr);
+		attr.type = type;
+		attr.config = config;
+		attr.disabled = 1;
+		attr.exclude_kernel = 1;
+		attr.exclude_hv = 1;
+		// When there are more events than hardware counters the kernel multiplexes them. These say for
+		// how long each one actually counted, to scale it.
+		attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+		return static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+	}
+	static constexpr std::uint64_t cache(const std::uint64_t id) {
+		return id | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+	}
+#endif
+public:
+	Counters() {
+		_fd.fill(-1);
+#if defined(BENCH_PERF_EVENTS)
+		_fd[cycles] = open(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES);
+		const int error = errno;
+		_fd[instructions] = open(PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS);
+		_fd[l1d_misses] = open(PERF_TYPE_HW_CACHE, cache(PERF_COUNT_HW_CACHE_L1D));
+		_fd[llc_misses] = open(PERF_TYPE_HW_CACHE, cache(PERF_COUNT_HW_CACHE_LL));
+		_fd[branch_misses] = open(PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES);
+		// Floating point instructions have no generic event. FP_ARITH_INST_RETIRED (event 0xC7) exists
+		// on Intel since Broadwell: umasks 0x01 and 0x02 are scalar, 0x04 to 0x80 packed 128 to 512 bits.
+		if (intel()) {
+			_fd[fp_vector] = open(PERF_TYPE_RAW, 0xFCC7);
+			_fd[fp_scalar] = open(PERF_TYPE_RAW, 0x03C7);
+		}
+		if (available())
+			_status = "perf_event_open";
+		else if (error == ENOENT || error == EOPNOTSUPP)
+			_status = "unavailable, no hardware performance counters (virtual machine?)";
+		else if (error == EACCES || error == EPERM)
+			_status = "unavailable, perf_event_open: " + std::string(std::strerror(error)) + " (see kernel.perf_event_paranoid)";
+		else
+			_status = "unavailable, perf_event_open: " + std::string(std::strerror(error));
+#else
+		_status = "unavailable, perf_event_open is Linux only";
+#endif
+	}
+	Counters(const Counters&) = delete;
+	Counters& operator=(const Counters&) = delete;
+	~Counters() {
+#if defined(BENCH_PERF_EVENTS)
+		for (const int fd : _fd)
+			if (fd >= 0) close(fd);
+#endif
+	}
+	bool available(const counter c) const {
+		return _fd[c] >= 0;
+	}
+	bool available() const {
+		for (const int fd : _fd)
+			if (fd >= 0) return true;
+		return false;
+	}
+	// Which counters are read, or why none is
+	const std::string& status() const {
+		return _status;
+	}
+	void start() {
+#if defined(BENCH_PERF_EVENTS)
+		for (const int fd : _fd)
+			if (fd >= 0) {
+				ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+				ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+			}
+#endif
+	}
+	CounterSample stop() {
+		CounterSample s;
+#if defined(BENCH_PERF_EVENTS)
+		for (const int fd : _fd)
+			if (fd >= 0) ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+		for (int c = 0; c < counter_count; ++c) {
+			std::uint64_t data[3]; // value, time enabled, time running
+			if (_fd[c] < 0 || read(_fd[c], data, sizeof(data)) != sizeof(data) || data[2] == 0)
+				continue;
+			s.value[c] = static_cast<double>(data[0]) * (static_cast<double>(data[1]) / data[2]);
+			s.valid[c] = true;
+		}
+#endif
+		return s;
+	}
+};
+
+}
@@ -0,0 +1,580 @@
+#pragma once
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+#if defined(__linux__)
+#include <sched.h>
+#endif
+#include "baseline.h"
+#include "counters.h"
+
+/*
+ * This file is part of the Vector3D distribution (https://github.com/cdelv/Vector3D).
+ * Copyright (c) 2022 Carlos Andres del Valle.
+ *
+ * Vector3D is under the terms of the BSD-3 license. We welcome feedback and contributions.
+ *
+ * you should have received a copy of the BSD3 Public License
+ * along with this program. If not, see <https://github.com/cdelv/Vector3D> LICENSE.
+ *
+ *
+ * This library requires C++20.
+*/
+
+/*
+*  Benchmark harness. Every benchmark is a pass over n elements. The pass is run a few times to warm up
+*  the caches and to find how many repetitions make a trial last at least min_trial_ms, then it is timed
+*  over many trials. The result is the distribution of the time per element over the trials.
+*/
+namespace bench {
+
+// Keeps the compiler from discarding a value, or the computation that produced it
+template <typename T>
+inline void do_not_optimize(const T& value) {
+#if defined(__GNUC__)
+	if constexpr (std::is_trivially_copyable_v<T> && sizeof(T) <= sizeof(void*))
+		asm volatile("" : : "r,m"(value) : "memory");
+	else
+		asm volatile("" : : "m"(value) : "memory");
+#else
+	const volatile T* sink = &value;
+	(void)sink;
+#endif
+}
+// Makes every pending write to memory observable, so stores of a pass cannot be dropped
+inline void clobber_memory() {
+#if defined(__GNUC__)
+	asm volatile("" : : : "memory");
+#endif
+}
+
+// Pins the calling thread to a CPU, so that it is not migrated between trials
+inline bool pin_thread(const int cpu) {
+#if defined(__linux__)
+	cpu_set_t set;
+	CPU_ZERO(&set);
+	CPU_SET(cpu, &set);
+	return sched_setaffinity(0, sizeof(set), &set) == 0;
+#else
+	(void)cpu;
+	return false;
+#endif
+}
+inline int current_cpu() {
+#if defined(__linux__)
+	return sched_getcpu();
+#else
+	return -1;
+#endif
+}
+
+struct Options {
+	std::size_t n = 500000;        // elements per pass
+	std::size_t warmup = 3;        // passes before timing
+	std::size_t trials = 25;       // timed trials
+	double min_trial_ms = 5;       // a trial repeats the pass until it lasts at least this
+	int cpu = -2;                  // CPU to pin to. -2: the one the program starts on, -1: don't pin
+	std::string format = "table";  // table, json or csv
+	std::string output;            // file for the report, standard output if empty
+	std::string filter;            // only run the benchmarks whose name contains it
+	bool counters = false;         // read the hardware performance counters
+	std::size_t min_bytes = 4 << 10;   // working set range of the sweeps
+	std::size_t max_bytes = 512 << 20;
+	std::string save_baseline;     // file to save the samples to
+	std::string baseline;          // file of an earlier run to compare against
+	double threshold = 5;          // slowdown of the median, in percent, that is a regression
+	double alpha = 0.01;           // significance level of the comparison
+};
+inline void usage(std::ostream& os, const char* program) {
+	os << "Usage: " << program << " [options]\n"
+	   << "  --n=N            elements per pass\n"
+	   << "  --warmup=N       untimed passes before the trials\n"
+	   << "  --trials=N       timed trials\n"
+	   << "  --min-time=MS    minimum duration of a trial in milliseconds\n"
+	   << "  --cpu=N          pin to CPU N, -1 to not pin\n"
+	   << "  --format=F       table, json or csv\n"
+	   << "  --output=FILE    write the report to FILE\n"
+	   << "  --filter=TEXT    run only the benchmarks whose name or variant contains TEXT\n"
+	   << "  --min-bytes=B    smallest working set of a sweep, with an optional K, M or G suffix\n"
+	   << "  --max-bytes=B    largest working set of a sweep\n"
+	   << "  --counters       also read the hardware performance counters\n"
+	   << "  --save-baseline=FILE  save the samples of this run to FILE\n"
+	   << "  --baseline=FILE  compare against the baseline in FILE, exit with 1 on regressions\n"
+	   << "  --threshold=PCT  median slowdown that is a regression, 5 by default\n"
+	   << "  --alpha=P        significance level of the comparison, 0.01 by default\n";
+}
+// Size in bytes with an optional K, M or G suffix
+inline std::size_t parse_bytes(const std::string& value) {
+	std::size_t pos = 0;
+	std::size_t bytes = std::stoul(value, &pos);
+	const std::string suffix = value.substr(pos);
+	if (suffix == "K") bytes <<= 10;
+	else if (suffix == "M") bytes <<= 20;
+	else if (suffix == "G") bytes <<= 30;
+	else if (!suffix.empty()) throw std::invalid_argument("bench: bad size " + value);
+	return bytes;
+}
+// Parses --key=value arguments over the given defaults. Throws std::invalid_argument on anything it does not know.
+inline Options parse_options(const int argc, char const* argv[], Options options = Options()) {
+	for (int i = 1; i < argc; ++i) {
+		const std::string arg = argv[i];
+		if (arg == "--counters") {
+			options.counters = true;
+			continue;
+		}
+		const std::size_t eq = arg.find('=');
+		if (arg.rfind("--", 0) != 0 || eq == std::string::npos)
+			throw std::invalid_argument("bench: unknown argument " + arg);
+		const std::string key = arg.substr(2, eq - 2), value = arg.substr(eq + 1);
+		static const std::vector<std::string> keys = {"n", "warmup", "trials", "min-time", "cpu", "format", "output", "filter", "min-bytes", "max-bytes", "save-baseline", "baseline", "threshold", "alpha"};
+		if (std::find(keys.begin(), keys.end(), key) == keys.end())
+			throw std::invalid_argument("bench: unknown argument " + arg);
+		try {
+			if (key == "n") options.n = std::stoul(value);
+			else if (key == "warmup") options.warmup = std::stoul(value);
+			else if (key == "trials") options.trials = std::stoul(value);
+			else if (key == "min-time") options.min_trial_ms = std::stod(value);
+			else if (key == "cpu") options.cpu = std::stoi(value);
+			else if (key == "format") options.format = value;
+			else if (key == "output") options.output = value;
+			else if (key == "filter") options.filter = value;
+			else if (key == "min-bytes") options.min_bytes = parse_bytes(value);
+			else if (key == "max-bytes") options.max_bytes = parse_bytes(value);
+			else if (key == "save-baseline") options.save_baseline = value;
+			else if (key == "baseline") options.baseline = value;
+			else if (key == "threshold") options.threshold = std::stod(value);
+			else if (key == "alpha") options.alpha = std::stod(value);
+		}
+		catch (const std::logic_error&) {
+			throw std::invalid_argument("bench: bad value in " + arg);
+		}
+	}
+	if (options.format != "table" && options.format != "json" && options.format != "csv")
+		throw std::invalid_argument("bench: unknown format " + options.format);
+	if (options.n == 0 || options.trials == 0)
+		throw std::invalid_argument("bench: n and trials must be positive");
+	if (options.min_bytes == 0 || options.min_bytes > options.max_bytes)
+		throw std::invalid_argument("bench: bad working set range");
+	if (options.threshold < 0 || options.alpha <= 0 || options.alpha >= 1)
+		throw std::invalid_argument("bench: bad threshold or alpha");
+	// Fail now rather than after the whole run
+	if (!options.baseline.empty()) {
+		try {
+			load_baseline(options.baseline);
+		}
+		catch (const std::runtime_error& e) {
+			throw std::invalid_argument(e.what());
+		}
+	}
+	return options;
+}
+
+// Summary of a sample
+struct Stats {
+	double median = 0, p95 = 0, mean = 0, stddev = 0, min = 0, max = 0;
+};
+// Quantile q of a sorted sample, interpolating between the closest ranks
+inline double quantile(const std::vector<double>& sorted, const double q) {
+	if (sorted.empty()) return 0;
+	const double pos = q * (sorted.size() - 1);
+	const std::size_t lo = static_cast<std::size_t>(pos);
+	const std::size_t hi = std::min(lo + 1, sorted.size() - 1);
+	return sorted[lo] + (pos - lo) * (sorted[hi] - sorted[lo]);
+}
+inline Stats summarize(std::vector<double> sample) {
+	Stats s;
+	if (sample.empty()) return s;
+	std::sort(sample.begin(), sample.end());
+	s.median = quantile(sample, 0.5);
+	s.p95 = quantile(sample, 0.95);
+	s.min = sample.front();
+	s.max = sample.back();
+	for (const double x : sample) s.mean += x;
+	s.mean /= sample.size();
+	if (sample.size() > 1) {
+		for (const double x : sample) s.stddev += (x - s.mean) * (x - s.mean);
+		s.stddev = std::sqrt(s.stddev / (sample.size() - 1));
+	}
+	return s;
+}
+
+struct Result {
+	std::string name;              // operation
+	std::string variant;           // implementation of the operation
+	std::size_t n = 0;             // elements per pass
+	std::size_t repetitions = 0;   // passes per trial
+	std::size_t bytes = 0;         // working set of a sweep point, 0 outside sweeps
+	std::vector<double> samples;   // nanoseconds per element, one per trial
+	Stats stats;
+	CounterSample counters;        // per element, over all the trials
+};
+
+class Harness {
+	Options _options;
+	std::vector<Result> _results;
+	int _cpu = -1;
+	std::unique_ptr<Counters> _counters;
+
+	static double elapsed_ns(const std::chrono::steady_clock::time_point start) {
+		return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+	}
+public:
+	explicit Harness(const Options& options) : _options(options) {
+		_cpu = options.cpu == -2 ? current_cpu() : options.cpu;
+		if (_cpu >= 0 && !pin_thread(_cpu))
+			_cpu = -1;
+		if (options.counters)
+			_counters = std::make_unique<Counters>();
+	}
+	const Options& options() const {
+		return _options;
+	}
+	const std::vector<Result>& results() const {
+		return _results;
+	}
+	// CPU the harness runs on, -1 if not pinned
+	int cpu() const {
+		return _cpu;
+	}
+	bool selected(const std::string& name, const std::string& variant = "") const {
+		return _options.filter.empty() || name.find(_options.filter) != std::string::npos
+		       || variant.find(_options.filter) != std::string::npos;
+	}
+	// Working sets of a sweep: powers of 2 from min_bytes to max_bytes
+	std::vector<std::size_t> sweep_sizes() const {
+		std::vector<std::size_t> sizes;
+		for (std::size_t b = _options.min_bytes; b <= _options.max_bytes; b *= 2)
+			sizes.push_back(b);
+		return sizes;
+	}
+	// Times pass(), which processes n elements. The result is kept for the report and returned.
+	// bytes is the working set when the benchmark is a point of a sweep.
+	template <typename F>
+	const Result* run(const std::string& name, const std::string& variant, F&& pass, const std::size_t n = 0, const std::size_t bytes = 0) {
+		if (!selected(name, variant)) return nullptr;
+		Result r;
+		r.name = name;
+		r.variant = variant;
+		r.n = n ? n : _options.n;
+		r.bytes = bytes;
+
+		// Warmup, and the number of passes that makes a trial long enough
+		double pass_ns = 0;
+		for (std::size_t w = 0; w < std::max<std::size_t>(_options.warmup, 1); ++w) {
+			const auto start = std::chrono::steady_clock::now();
+			pass();
+			clobber_memory();
+			pass_ns = elapsed_ns(start);
+		}
+		r.repetitions = std::max<std::size_t>(1, static_cast<std::size_t>(std::ceil(_options.min_trial_ms * 1e6 / std::max(pass_ns, 1.0))));
+
+		r.samples.reserve(_options.trials);
+		if (_counters) _counters->start();
+		for (std::size_t t = 0; t < _options.trials; ++t) {
+			const auto start = std::chrono::steady_clock::now();
+			for (std::size_t k = 0; k < r.repetitions; ++k) {
+				pass();
+				clobber_memory();
+			}
+			r.samples.push_back(elapsed_ns(start) / (r.repetitions * r.n));
+		}
+		if (_counters) {
+			r.counters = _counters->stop();
+			r.counters /= static_cast<double>(_options.trials * r.repetitions * r.n);
+		}
+		r.stats = summarize(r.samples);
+		_results.push_back(std::move(r));
+		return &_results.back();
+	}
+
+	/*
+	*  Reports
+	*/
+	// Operations per microsecond from nanoseconds per operation
+	static double throughput(const double ns) {
+		return ns > 0 ? 1e3 / ns : 0;
+	}
+	// Writes s left aligned in a field of w characters. setw counts bytes, not UTF-8 characters.
+	static void cell(std::ostream& os, const std::string& s, const std::size_t w) {
+		const std::size_t chars = std::count_if(s.begin(), s.end(), [](const char c) { return (c & 0xC0) != 0x80; });
+		os << s << std::string(w > chars ? w - chars : 0, ' ') << "| ";
+	}
+	static std::string throughput_cell(const Result& r) {
+		std::ostringstream c;
+		c << std::fixed << std::setprecision(1) << throughput(r.stats.median) << " ±" << 100 * r.stats.stddev / r.stats.mean << "%";
+		return c.str();
+	}
+	static std::string size_label(const std::size_t bytes) {
+		if (bytes >= (1 << 30) && bytes % (1 << 30) == 0) return std::to_string(bytes >> 30) + " GiB";
+		if (bytes >= (1 << 20) && bytes % (1 << 20) == 0) return std::to_string(bytes >> 20) + " MiB";
+		if (bytes >= (1 << 10) && bytes % (1 << 10) == 0) return std::to_string(bytes >> 10) + " KiB";
+		return std::to_string(bytes) + " B";
+	}
+	// Variant, and the working set of sweep points
+	static std::string label(const Result& r) {
+		return r.bytes ? r.variant + ", " + size_label(r.bytes) : r.variant;
+	}
+	// For sweeps, one table per operation with one row per working set and one column per variant
+	void sweep_table(std::ostream& os) const {
+		std::vector<std::string> names, variants;
+		std::vector<std::size_t> sizes;
+		std::size_t w = 14;
+		for (const Result& r : _results) {
+			if (std::find(names.begin(), names.end(), r.name) == names.end()) names.push_back(r.name);
+			if (std::find(variants.begin(), variants.end(), r.variant) == variants.end()) variants.push_back(r.variant);
+			if (std::find(sizes.begin(), sizes.end(), r.bytes) == sizes.end()) sizes.push_back(r.bytes);
+			w = std::max(w, r.variant.size() + 1);
+		}
+		std::sort(sizes.begin(), sizes.end());
+		for (const std::string& name : names) {
+			std::vector<std::string> measured;
+			for (const std::string& v : variants)
+				if (std::any_of(_results.begin(), _results.end(), [&](const Result& r) { return r.name == name && r.variant == v; }))
+					measured.push_back(v);
+			const std::string line = std::string(13 + (w + 2) * measured.size(), '-') + "|";
+			os << std::endl << " " << name << std::endl << " ";
+			cell(os, "Working set", 11);
+			for (const std::string& v : measured) cell(os, v, w);
+			os << std::endl << line << std::endl;
+			for (const std::size_t b : sizes) {
+				os << " ";
+				cell(os, size_label(b), 11);
+				for (const std::string& v : measured) {
+					const auto it = std::find_if(_results.begin(), _results.end(), [&](const Result& r) { return r.name == name && r.variant == v && r.bytes == b; });
+					cell(os, it != _results.end() ? throughput_cell(*it) : "-", w);
+				}
+				os << std::endl;
+			}
+			os << line << std::endl;
+		}
+		os << "( Median operations/μs ± relative standard deviation over " << _options.trials << " trials )" << std::endl;
+		os << "CPU: ";
+		if (_cpu >= 0) os << _cpu; else os << "not pinned";
+		os << std::endl << std::endl;
+		if (_counters) counter_table(os);
+	}
+	// One row per operation and one column per variant, with the median throughput and its spread
+	void table(std::ostream& os) const {
+		if (std::any_of(_results.begin(), _results.end(), [](const Result& r) { return r.bytes > 0; })) {
+			sweep_table(os);
+			return;
+		}
+		std::vector<std::string> names, variants;
+		for (const Result& r : _results) {
+			if (std::find(names.begin(), names.end(), r.name) == names.end()) names.push_back(r.name);
+			if (std::find(variants.begin(), variants.end(), r.variant) == variants.end()) variants.push_back(r.variant);
+		}
+		const std::size_t w = 17;
+		os << std::endl << " ";
+		cell(os, "Operation", 13);
+		for (const std::string& v : variants) cell(os, v, w);
+		os << std::endl << std::string(15 + (w + 2) * variants.size() - 1, '-') << "|" << std::endl;
+		for (const std::string& name : names) {
+			os << " ";
+			cell(os, name, 13);
+			for (const std::string& v : variants) {
+				const auto it = std::find_if(_results.begin(), _results.end(), [&](const Result& r) { return r.name == name && r.variant == v; });
+				cell(os, it != _results.end() ? throughput_cell(*it) : "-", w);
+			}
+			os << std::endl;
+		}
+		os << std::string(15 + (w + 2) * variants.size() - 1, '-') << "|" << std::endl;
+		os << "( Median operations/μs ± relative standard deviation over " << _options.trials << " trials )" << std::endl;
+		os << "Elements per pass: " << _options.n << ", CPU: ";
+		if (_cpu >= 0) os << _cpu; else os << "not pinned";
+		os << std::endl << std::endl;
+		if (_counters) counter_table(os);
+	}
+	// One row per benchmark with the counts per element
+	void counter_table(std::ostream& os) const {
+		os << "Hardware counters: " << _counters->status() << std::endl;
+		if (!_counters->available()) {
+			os << std::endl;
+			return;
+		}
+		const std::size_t w = 10;
+		std::size_t vw = 11;
+		for (const Result& r : _results) vw = std::max(vw, label(r).size() + 1);
+		os << std::endl << " ";
+		cell(os, "Operation", 13);
+		cell(os, "Variant", vw);
+		for (const char* h : {"cycles", "instr", "IPC", "L1d miss", "LLC miss", "br miss", "fp vec", "fp scalar"})
+			cell(os, h, w);
+		os << std::endl << std::string(17 + vw + (w + 2) * 8 - 1, '-') << "|" << std::endl;
+		for (const Result& r : _results) {
+			os << " ";
+			cell(os, r.name, 13);
+			cell(os, label(r), vw);
+			const auto value = [&](const counter c) {
+				std::ostringstream v;
+				if (r.counters.valid[c]) v << std::fixed << std::setprecision(c == l1d_misses || c == llc_misses || c == branch_misses ? 3 : 2) << r.counters.value[c];
+				else v << "-";
+				return v.str();
+			};
+			cell(os, value(cycles), w);
+			cell(os, value(instructions), w);
+			std::ostringstream ipc;
+			if (r.counters.ipc() > 0) ipc << std::fixed << std::setprecision(2) << r.counters.ipc();
+			else ipc << "-";
+			cell(os, ipc.str(), w);
+			for (const counter c : {l1d_misses, llc_misses, branch_misses, fp_vector, fp_scalar})
+				cell(os, value(c), w);
+			os << std::endl;
+		}
+		os << std::string(17 + vw + (w + 2) * 8 - 1, '-') << "|" << std::endl;
+		os << "( Counts per element )" << std::endl << std::endl;
+	}
+	void json(std::ostream& os) const {
+		const auto quote = [](const std::string& s) {
+			std::string q = "\"";
+			for (const char c : s) {
+				if (c == '"' || c == '\\') q += '\\';
+				q += c;
+			}
+			return q + "\"";
+		};
+		os << std::setprecision(6) << "{\n  \"trials\": " << _options.trials << ",\n  \"cpu\": " << _cpu;
+		if (_counters)
+			os << ",\n  \"counters\": " << quote(_counters->status());
+		os << ",\n  \"unit\": \"ns/element\",\n  \"results\": [";
+		for (std::size_t i = 0; i < _results.size(); ++i) {
+			const Result& r = _results[i];
+			os << (i ? ",\n" : "\n") << "    {\"name\": " << quote(r.name) << ", \"variant\": " << quote(r.variant)
+			   << ", \"n\": " << r.n << ", \"bytes\": " << r.bytes << ", \"repetitions\": " << r.repetitions
+			   << ", \"median\": " << r.stats.median << ", \"p95\": " << r.stats.p95 << ", \"mean\": " << r.stats.mean
+			   << ", \"stddev\": " << r.stats.stddev << ", \"min\": " << r.stats.min << ", \"max\": " << r.stats.max
+			   << ", \"samples\": [";
+			for (std::size_t t = 0; t < r.samples.size(); ++t)
+				os << (t ? ", " : "") << r.samples[t];
+			os << "]";
+			// Counts per element, only the ones that could be read
+			if (r.counters.any()) {
+				os << ", \"counters\": {";
+				bool first = true;
+				for (int c = 0; c < counter_count; ++c)
+					if (r.counters.valid[c]) {
+						os << (first ? "" : ", ") << quote(counter_name(static_cast<counter>(c))) << ": " << r.counters.value[c];
+						first = false;
+					}
+				if (r.counters.ipc() > 0)
+					os << ", \"ipc\": " << r.counters.ipc();
+				os << "}";
+			}
+			os << "}";
+		}
+		os << "\n  ]\n}" << std::endl;
+	}
+	void csv(std::ostream& os) const {
+		const auto field = [](const std::string& s) {
+			if (s.find_first_of(",\"") == std::string::npos) return s;
+			std::string q = "\"";
+			for (const char c : s) {
+				if (c == '"') q += '"';
+				q += c;
+			}
+			return q + "\"";
+		};
+		os << std::setprecision(6) << "name,variant,n,bytes,repetitions,median_ns,p95_ns,mean_ns,stddev_ns,min_ns,max_ns";
+		// Counts per element, empty when they could not be read
+		if (_counters) {
+			for (int c = 0; c < counter_count; ++c)
+				os << "," << counter_name(static_cast<counter>(c));
+			os << ",ipc";
+		}
+		os << std::endl;
+		for (const Result& r : _results) {
+			os << field(r.name) << "," << field(r.variant) << "," << r.n << "," << r.bytes << "," << r.repetitions << ","
+			   << r.stats.median << "," << r.stats.p95 << "," << r.stats.mean << ","
+			   << r.stats.stddev << "," << r.stats.min << "," << r.stats.max;
+			if (_counters) {
+				for (int c = 0; c < counter_count; ++c) {
+					os << ",";
+					if (r.counters.valid[c]) os << r.counters.value[c];
+				}
+				os << ",";
+				if (r.counters.ipc() > 0) os << r.counters.ipc();
+			}
+			os << std::endl;
+		}
+	}
+	std::vector<Record> records() const {
+		std::vector<Record> records;
+		for (const Result& r : _results)
+			records.push_back({r.name, r.variant, r.bytes, r.n, r.samples});
+		return records;
+	}
+	// Median time per element against the baseline. Returns the number of regressions.
+	std::size_t comparison_table(std::ostream& os, const std::vector<Comparison>& comparisons) const {
+		std::size_t vw = 11, regressions = 0;
+		for (const Result& r : _results) vw = std::max(vw, label(r).size() + 1);
+		const std::size_t w = 12;
+		const std::string line = std::string(15 + vw + 2 + (w + 2) * 4, '-') + std::string(17, '-') + "|";
+		os << std::endl << "Comparison with " << _options.baseline << std::endl << " ";
+		cell(os, "Operation", 13);
+		cell(os, "Variant", vw);
+		for (const char* h : {"baseline ns", "current ns", "change", "p-value"})
+			cell(os, h, w);
+		cell(os, "result", 15);
+		os << std::endl << line << std::endl;
+		for (std::size_t i = 0; i < comparisons.size(); ++i) {
+			const Comparison& c = comparisons[i];
+			os << " ";
+			cell(os, c.name, 13);
+			cell(os, label(_results[i]), vw);
+			std::ostringstream b, t, d, p;
+			b << std::fixed << std::setprecision(3);
+			t << std::fixed << std::setprecision(3) << c.current;
+			if (c.result != Comparison::added) {
+				b << c.baseline;
+				d << std::showpos << std::fixed << std::setprecision(1) << 100 * c.change << "%";
+				p << std::setprecision(2) << c.p;
+			}
+			cell(os, b.str(), w);
+			cell(os, t.str(), w);
+			cell(os, d.str(), w);
+			cell(os, p.str(), w);
+			cell(os, verdict_name(c.result), 15);
+			os << std::endl;
+			if (c.result == Comparison::slower) ++regressions;
+		}
+		os << line << std::endl;
+		os << "( Regressions: " << regressions << ", the median slower by more than " << _options.threshold
+		   << "% with p < " << _options.alpha << " )" << std::endl << std::endl;
+		return regressions;
+	}
+	// Writes the report in the format and to the destination of the options, then saves the baseline
+	// and compares against the earlier one if asked. Returns the exit status: 1 if there were regressions.
+	int report() const {
+		std::ofstream file;
+		if (!_options.output.empty()) {
+			file.open(_options.output);
+			if (!file)
+				throw std::runtime_error("bench: cannot open " + _options.output);
+		}
+		std::ostream& os = _options.output.empty() ? std::cout : file;
+		if (_options.format == "json") json(os);
+		else if (_options.format == "csv") csv(os);
+		else table(os);
+
+		if (!_options.save_baseline.empty())
+			save_baseline(_options.save_baseline, records());
+		if (_options.baseline.empty())
+			return 0;
+		const auto comparisons = compare(load_baseline(_options.baseline), records(), _options.threshold / 100, _options.alpha);
+		// Keeps JSON and CSV on the standard output parsable
+		std::ostream& out = _options.format != "table" && _options.output.empty() ? std::cerr : std::cout;
+		return comparison_table(out, comparisons) ? 1 : 0;
+	}
+};
+
+}
@@ -0,0 +1,105 @@
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../vector_reduce.h"
+#include "harness.h"
+
+/*
+*  Reductions over a std::vector of vector3D<double>: a plain loop over the vectors, vector_reduce.h on
+*  the calling thread, where only the vectorized kernels differ, and vector_reduce.h on every hardware
+*  thread. The process isn't pinned, so that the threads can spread. The deterministic reductions use
+*  every thread too. The sums of vector3D<float> compare the accumulation policies on one thread.
+*/
+
+int main(int argc, char const* argv[]) {
+	bench::Options defaults;
+	defaults.trials = 10;
+	defaults.n = 4000000;
+	defaults.cpu = -1;
+	bench::Options options;
+	try {
+		options = bench::parse_options(argc, argv, defaults);
+	}
+	catch (const std::invalid_argument& e) {
+		std::cerr << e.what() << std::endl;
+		bench::usage(std::cerr, argv[0]);
+		return 2;
+	}
+	bench::Harness h(options);
+
+	const std::size_t N = options.n;
+	std::default_random_engine re(10);
+	std::uniform_real_distribution<double> rand(-1.0, 1.0);
+	std::vector<vector3D<double>> v(N);
+	std::vector<double> w(N);
+	for (std::size_t i = 0; i < N; i++) {
+		v[i].load(rand(re), rand(re), rand(re));
+		w[i] = rand(re) + 1;
+	}
+	reduce_options one;
+	one.threads = 1;
+	const reduce_options all;
+	reduce_options fixed;
+	fixed.deterministic = true;
+	const std::string threads = "threads: " + std::to_string(std::max(1u, std::thread::hardware_concurrency()));
+
+	h.run("sum", "loop", [&] {
+		vector3D<double> s(0, 0, 0);
+		for (const vector3D<double>& u : v)
+			s += u;
+		bench::do_not_optimize(s);
+	}, N);
+	h.run("sum", "threads: 1", [&] { bench::do_not_optimize(parallel_sum(v, one)); }, N);
+	h.run("sum", threads, [&] { bench::do_not_optimize(parallel_sum(v, all)); }, N);
+	h.run("sum", "deterministic", [&] { bench::do_not_optimize(parallel_sum(v, fixed)); }, N);
+
+	h.run("weighted sum", "loop", [&] {
+		vector3D<double> s(0, 0, 0);
+		for (std::size_t i = 0; i < N; i++)
+			s += w[i] * v[i];
+		bench::do_not_optimize(s);
+	}, N);
+	h.run("weighted sum", "threads: 1", [&] { bench::do_not_optimize(parallel_weighted_sum(v, w, one)); }, N);
+	h.run("weighted sum", threads, [&] { bench::do_not_optimize(parallel_weighted_sum(v, w, all)); }, N);
+	h.run("weighted sum", "deterministic", [&] { bench::do_not_optimize(parallel_weighted_sum(v, w, fixed)); }, N);
+
+	h.run("bounds", "loop", [&] {
+		vector3D<double> lo = v[0], hi = v[0];
+		for (const vector3D<double>& u : v)
+			for (std::size_t k = 0; k < 3; k++) {
+				lo[k] = std::min(lo[k], u[k]);
+				hi[k] = std::max(hi[k], u[k]);
+			}
+		bench::do_not_optimize(lo);
+		bench::do_not_optimize(hi);
+	}, N);
+	h.run("bounds", "threads: 1", [&] { bench::do_not_optimize(parallel_bounds(v, one)); }, N);
+	h.run("bounds", threads, [&] { bench::do_not_optimize(parallel_bounds(v, all)); }, N);
+
+	h.run("max norm", "loop", [&] {
+		double m = 0;
+		for (const vector3D<double>& u : v)
+			m = std::max(m, norm2(u));
+		bench::do_not_optimize(m);
+	}, N);
+	h.run("max norm", "threads: 1", [&] { bench::do_not_optimize(parallel_max_norm(v, one)); }, N);
+	h.run("max norm", threads, [&] { bench::do_not_optimize(parallel_max_norm(v, all)); }, N);
+
+	// Sums of vector3D<float> with each accumulation policy, on the calling thread
+	std::vector<vector3D<float>> f(N);
+	for (std::size_t i = 0; i < N; i++)
+		f[i] = v[i];
+	h.run("float sum", "naive", [&] { bench::do_not_optimize(parallel_sum(f, naive_sum(), one)); }, N);
+	h.run("float sum", "widened", [&] { bench::do_not_optimize(parallel_sum(f, widened_sum(), one)); }, N);
+	h.run("float sum", "kahan", [&] { bench::do_not_optimize(parallel_sum(f, kahan_sum(), one)); }, N);
+	h.run("float sum", "pairwise", [&] { bench::do_not_optimize(parallel_sum(f, pairwise_sum(), one)); }, N);
+
+	h.run("covariance", "threads: 1", [&] { bench::do_not_optimize(parallel_covariance(v, one)); }, N);
+	h.run("covariance", threads, [&] { bench::do_not_optimize(parallel_covariance(v, all)); }, N);
+	h.run("covariance", "deterministic", [&] { bench::do_not_optimize(parallel_covariance(v, fixed)); }, N);
+
+	return h.report();
+}
@@ -0,0 +1,90 @@
+#include <complex>
+#include <iostream>
+#include <random>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include "../vector.h"
+#include "harness.h"
+
+/*
+*  Working set sweep. Every operation streams through arrays of vectors whose total size doubles from
+*  --min-bytes to --max-bytes, so the throughput curves show where each type falls out of L1, L2,
+*  the last level cache and into DRAM. The working set counts the two inputs and the output.
+*/
+
+// Fills the components of every vector with random numbers
+template <typename V, typename G>
+void fill(std::vector<V>& data, G& gen) {
+	std::uniform_real_distribution<double> rand(-1000.0, 1000.0);
+	for (V& v : data)
+		for (std::size_t k = 0; k < V::size(); k++)
+			v[k] = rand(gen);
+}
+
+template <typename V>
+void sweep(bench::Harness& h, const std::string& type, const std::size_t bytes) {
+	using T = std::remove_cvref_t<decltype(V()[0])>;
+	const std::size_t N = std::max<std::size_t>(bytes / (3 * sizeof(V)), 1);
+	std::default_random_engine re(10);
+	std::vector<V> U(N), W(N), R(N);
+	std::vector<T> S(N);
+	fill(U, re);
+	fill(W, re);
+	const T a = 1.5;
+	bench::do_not_optimize(R.data());
+	bench::do_not_optimize(S.data());
+
+	h.run("u + v", type, [&] {
+		for (std::size_t i = 0; i < N; i++)
+			R[i] = U[i] + W[i];
+	}, N, bytes);
+	h.run("a*u + v", type, [&] {
+		for (std::size_t i = 0; i < N; i++)
+			R[i] = a * U[i] + W[i];
+	}, N, bytes);
+	h.run("dot", type, [&] {
+		for (std::size_t i = 0; i < N; i++)
+			S[i] = dot(U[i], W[i]);
+	}, N, bytes);
+	h.run("norm", type, [&] {
+		for (std::size_t i = 0; i < N; i++)
+			S[i] = norm(U[i]);
+	}, N, bytes);
+	if constexpr (V::size() == 3)
+		h.run("cross", type, [&] {
+			for (std::size_t i = 0; i < N; i++)
+				R[i] = cross(U[i], W[i]);
+		}, N, bytes);
+}
+
+int main(int argc, char const* argv[]) {
+	// Large working sets take long to stream, so the defaults are lighter than for benchmark.x
+	bench::Options defaults;
+	defaults.trials = 10;
+	defaults.min_trial_ms = 2;
+	bench::Options options;
+	try {
+		options = bench::parse_options(argc, argv, defaults);
+	}
+	catch (const std::invalid_argument& e) {
+		std::cerr << e.what() << std::endl;
+		bench::usage(std::cerr, argv[0]);
+		return 2;
+	}
+	bench::Harness h(options);
+
+	for (const std::size_t bytes : h.sweep_sizes()) {
+		sweep<vector2D<float>>(h, "2D float", bytes);
+		sweep<vector2D<double>>(h, "2D double", bytes);
+		sweep<vector3D<float>>(h, "3D float", bytes);
+		sweep<vector3D<double>>(h, "3D double", bytes);
+		sweep<vector3D<std::complex<double>>>(h, "3D complex", bytes);
+		sweep<vectorND<float, 8>>(h, "8D float", bytes);
+		sweep<vectorND<double, 8>>(h, "8D double", bytes);
+		sweep<vectorND<double, 16>>(h, "16D double", bytes);
+	}
+
+	return h.report();
+}
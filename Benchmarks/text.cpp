@@ -0,0 +1,105 @@
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../vector_text.h"
+#include "harness.h"
+
+/*
+*  Text files of vector3D<double>, one "x y z" per line with full precision. Loading with iostreams
+*  as before vector_text.h and with parse_vectors and read_vectors, and writing with iostreams and
+*  with format_vectors and vector_writer. Every pass reads or writes the whole file, so the rate is
+*  in vectors.
+*/
+
+int main(int argc, char const* argv[]) {
+	bench::Options defaults;
+	defaults.trials = 5;
+	defaults.min_trial_ms = 0;
+	defaults.n = 1000000;
+	bench::Options options;
+	try {
+		options = bench::parse_options(argc, argv, defaults);
+	}
+	catch (const std::invalid_argument& e) {
+		std::cerr << e.what() << std::endl;
+		bench::usage(std::cerr, argv[0]);
+		return 2;
+	}
+	bench::Harness h(options);
+
+	const std::size_t N = options.n;
+	std::default_random_engine re(10);
+	std::uniform_real_distribution<double> rand(-1000.0, 1000.0);
+	std::ostringstream s;
+	s.precision(17);
+	for (std::size_t i = 0; i < N; i++)
+		s << rand(re) << ' ' << rand(re) << ' ' << rand(re) << '\n';
+	const std::string text = s.str();
+	const std::string path = "text_benchmark.txt";
+	std::ofstream(path, std::ios::binary) << text;
+	std::vector<vector3D<double>> v;
+	bench::do_not_optimize(v);
+	text_options threads;
+	threads.threads = 0;
+	const std::string all = "threads: " + std::to_string(std::max(1u, std::thread::hardware_concurrency()));
+
+	h.run("read string", "iostream", [&] {
+		std::istringstream in(text);
+		v.clear();
+		double x, y, z;
+		while (in >> x >> y >> z)
+			v.emplace_back(x, y, z);
+	}, N);
+	h.run("read string", "charconv", [&] {
+		v = parse_vectors<vector3D<double>>(text);
+	}, N);
+	h.run("read string", all, [&] {
+		v = parse_vectors<vector3D<double>>(text, threads);
+	}, N);
+	h.run("read file", "iostream", [&] {
+		std::ifstream in(path);
+		v.clear();
+		double x, y, z;
+		while (in >> x >> y >> z)
+			v.emplace_back(x, y, z);
+	}, N);
+	h.run("read file", "charconv", [&] {
+		v = read_vectors<vector3D<double>>(path);
+	}, N);
+	h.run("read file", all, [&] {
+		v = read_vectors<vector3D<double>>(path, threads);
+	}, N);
+
+	// 17 digits for both, as in the file that was read
+	format_options digits;
+	digits.precision = 17;
+	h.run("write string", "iostream", [&] {
+		std::ostringstream out;
+		out.precision(17);
+		for (const vector3D<double>& u : v)
+			out << u.x << ' ' << u.y << ' ' << u.z << '\n';
+		bench::do_not_optimize(out);
+	}, N);
+	h.run("write string", "charconv", [&] {
+		bench::do_not_optimize(format_vectors(v, digits));
+	}, N);
+	h.run("write file", "iostream", [&] {
+		std::ofstream out(path);
+		out.precision(17);
+		for (const vector3D<double>& u : v)
+			out << u.x << ' ' << u.y << ' ' << u.z << '\n';
+	}, N);
+	h.run("write file", "charconv", [&] {
+		vector_writer out(path, digits);
+		out.write(v);
+	}, N);
+	std::remove(path.c_str());
+
+	return h.report();
+}
@@ -0,0 +1,44 @@
+/*
+ * This file is part of the Vector3D distribution (https://github.com/cdelv/Vector3D).
+ * Copyright (c) 2022 Carlos Andres del Valle.
+ *
+ *Vector3D is under the terms of the BSD-3 license. We welcome feedback and contributions.
+ *
+ * You should have received a copy of the BSD3 Public License
+ * along with this program. If not, see <https://github.com/cdelv/Vector3D> LICENSE.
+ *
+ *
+ * This library requires C++20.
+ */
+// Uses the library through import vector3d; for Test_Module.cpp. It includes no standard header:
+// GCC 12 can't yet merge them with the ones in the global module fragment of the module.
+import vector3d;
+
+void module_results(double *r) {
+    vector3D<double> a(1, 2, 3), b(4, 5, 6);
+    vector3D<double> c = a + 2.0 * b - cross(a, b);
+    r[0] = c.x;
+    r[1] = c.y;
+    r[2] = c.z;
+    r[3] = dot(a, b);
+    r[4] = a * b;
+    r[5] = norm(a);
+    r[6] = norm(unit(a + b));
+    r[7] = angle(a, 3.0 * a);
+
+    vector3D<double> e = eval(a ^ b);
+    r[8] = e.x;
+    e.unit();
+    r[9] = e.norm();
+    r[10] = (-(-a))[1];
+
+    vector2D<float> u(3, 4);
+    r[11] = norm(u);
+    r[12] = cross(u, vector2D<float>(0, 1));
+
+    vectorND<double, 5> v(1, 2, 3, 4, 5), w(1.0);
+    vectorND<double, 5> s = v - w / 2.0;
+    r[13] = s[4];
+    r[14] = sum(v);
+    r[15] = norm2(ElemProd(v, w));
+}
@@ -451,6 +451,122 @@ TEST(Composit_Operations, composit) {
     v = -v;
     EXPECT_EQ(v.z, -3);
 }
+//Compile time access
+TEST(Compile_time_access, get) {
+    vector3D<double> v(1, 2, 3), u(-1, 0.5, 4);
+    EXPECT_EQ(1, v.get<0>());
+    EXPECT_EQ(3, v.get<2>());
+    v.get<1>() = 5;
+    EXPECT_EQ(5, v.y);
+
+    // Nodes hold their operands by reference: the subexpressions must outlive expr
+    auto c = u ^ v;
+    auto t = 2 * c;
+    auto w = v + t;
+    auto h = u / 2.0;
+    auto expr = w - h;
+    vector3D<double> r = v + 2 * (u ^ v) - u / 2.0;
+    EXPECT_EQ(r.x, expr.get<0>());
+    EXPECT_EQ(r.y, expr.get<1>());
+    EXPECT_EQ(r.z, expr.get<2>());
+    EXPECT_EQ(r.x, expr[0]);
+    EXPECT_EQ(r.y, expr[1]);
+    EXPECT_EQ(r.z, expr[2]);
+
+    constexpr vector3D<int> a(1, 2, 3), b(4, 5, 6);
+    static_assert((a ^ b).get<0>() == -3);
+    static_assert(sum(a + b) == 21);
+    static_assert(dot(a, b) == 32);
+}
+//Algebraic simplification
+// Counts the components read from a vector
+struct counted : public __VecExpression<counted, 3> {
+    const vector3D<double> &v;
+    mutable int reads = 0;
+    counted(const vector3D<double> &v) : v(v) {}
+    double operator[](const std::size_t i) const { ++reads; return v[i]; }
+    template <std::size_t I>
+    double get() const { ++reads; return v[I]; }
+    static constexpr std::size_t size() { return 3; }
+};
+TEST(Simplification, rewrites) {
+    vector3D<double> u(1, 2, 3), v(4, -5, 6);
+    // The rewritten trees
+    static_assert(std::is_same_v<decltype(-(-u)), const vector3D<double>&>);
+    static_assert(std::is_same_v<decltype(u + (-v)), __VecSubtraction<vector3D<double>, vector3D<double>, 3>>);
+    static_assert(std::is_same_v<decltype((-u) + v), __VecSubtraction<vector3D<double>, vector3D<double>, 3>>);
+    static_assert(std::is_same_v<decltype(u - (-v)), __VecSum<vector3D<double>, vector3D<double>, 3>>);
+    static_assert(std::is_same_v<decltype(2.0 * (3.0 * u)), __LeftVecScalarProduct<vector3D<double>, double, 3>>);
+    static_assert(std::is_same_v<decltype((u * 2.0) * 3), __RightVecScalarProduct<vector3D<double>, double, 3>>);
+    static_assert(std::is_same_v<decltype(-(2.0 * u)), __LeftVecScalarProduct<vector3D<double>, double, 3>>);
+
+    vector3D<double> r = -(-u);
+    EXPECT_EQ(r.x, 1); EXPECT_EQ(r.y, 2); EXPECT_EQ(r.z, 3);
+    r = u + (-v);
+    EXPECT_EQ(r.x, -3); EXPECT_EQ(r.y, 7); EXPECT_EQ(r.z, -3);
+    r = (-u) + v;
+    EXPECT_EQ(r.x, 3); EXPECT_EQ(r.y, -7); EXPECT_EQ(r.z, 3);
+    r = (-u) + (-v);
+    EXPECT_EQ(r.x, -5); EXPECT_EQ(r.y, 3); EXPECT_EQ(r.z, -9);
+    r = u - (-v);
+    EXPECT_EQ(r.x, 5); EXPECT_EQ(r.y, -3); EXPECT_EQ(r.z, 9);
+    r = 2 * (u * 3) * 0.5;
+    EXPECT_EQ(r.x, 3); EXPECT_EQ(r.y, 6); EXPECT_EQ(r.z, 9);
+    r = -(u * 2);
+    EXPECT_EQ(r.x, -2); EXPECT_EQ(r.y, -4); EXPECT_EQ(r.z, -6);
+    r = u + v + v;
+    EXPECT_EQ(r.x, 9); EXPECT_EQ(r.y, -8); EXPECT_EQ(r.z, 15);
+    // A repeated operand is merged, p + 2q rounds once. Equal but distinct vectors are added as written.
+    vector3D<double> p(1, 1e16, 0.1), q(0.7, 1, 0.2), q2 = q;
+    r = p + q + q;
+    EXPECT_EQ(r.y, 1e16 + 2);
+    EXPECT_EQ((p + q + q).get<1>(), 1e16 + 2);
+    r = p + q + q2;
+    EXPECT_EQ(r.y, (1e16 + 1) + 1);
+    EXPECT_EQ((p + q + q2).get<1>(), (1e16 + 1) + 1);
+
+    // Folded scalars are held by value
+    auto expr = 2.0 * (3.0 * u);
+    EXPECT_EQ(expr.get<2>(), 18);
+
+    EXPECT_EQ(dot(u, u), norm2(u));
+    // dot(c, c) reads each component of c once, like norm2(c)
+    counted c(u);
+    EXPECT_EQ(dot(c, c), 14);
+    EXPECT_EQ(c.reads, 3);
+    counted d(u);
+    EXPECT_EQ(dot(c, d), 14);
+    EXPECT_EQ(c.reads + d.reads, 9);
+    EXPECT_EQ(norm2(u ^ v), dot(u ^ v, u ^ v));
+    constexpr vector3D<int> a(1, 2, 3);
+    static_assert(dot(a, a) == 14 && norm2(a) == 14);
+    static_assert((a + a + a).get<1>() == 6);
+}
+//Evaluation of costly operands
+TEST(Materialization, eval) {
+    vector3D<double> a(1, 2, 3), b(4, 5, 6), c(-1, 0, 2);
+    // The inner cross product is evaluated once instead of twice per component
+    static_assert(__cost_v<decltype(cross(cross(a, b), c))> == 3);
+    static_assert(__cost_v<decltype(cross(a, b) + c)> == 4);
+    static_assert(__cost_v<decltype(unit(a + b))> == 1);
+    static_assert(std::is_same_v<decltype(eval(a + b)), vector3D<double>>);
+    static_assert(std::is_same_v<decltype(eval(vector3D<int>(1) * 0.5)), vector3D<double>>);
+
+    vector3D<double> r = cross(cross(a, b), c);
+    EXPECT_EQ(r.x, 12); EXPECT_EQ(r.y, 9); EXPECT_EQ(r.z, 6);
+    r = (a ^ b) ^ (b ^ c);
+    vector3D<double> ab = a ^ b, bc = b ^ c, s = ab ^ bc;
+    EXPECT_EQ(r.x, s.x); EXPECT_EQ(r.y, s.y); EXPECT_EQ(r.z, s.z);
+    r = cross(eval(a + b), c);
+    EXPECT_EQ(r.x, 14); EXPECT_EQ(r.y, -19); EXPECT_EQ(r.z, 7);
+    r = unit(a + b);
+    vector3D<double> ApB = a + b;
+    EXPECT_DOUBLE_EQ(r.x, ApB.x / ApB.norm());
+    EXPECT_DOUBLE_EQ(r.z, ApB.z / ApB.norm());
+
+    constexpr vector3D<int> x(1, 2, 3), y(0, 1, 0);
+    static_assert(cross(cross(x, y), y).get<0>() == -1);
+}
 
 int main(int argc, char **argv)
 {
@@ -0,0 +1,199 @@
+/*
+ * This file is part of the Vector3D distribution (https://github.com/cdelv/Vector3D).
+ * Copyright (c) 2022 Carlos Andres del Valle.
+ *
+ *Vector3D is under the terms of the BSD-3 license. We welcome feedback and contributions.
+ *
+ * You should have received a copy of the BSD3 Public License
+ * along with this program. If not, see <https://github.com/cdelv/Vector3D> LICENSE.
+ *
+ *
+ * This library requires C++20.
+ */
+#include "../vector_array.h"
+#include <gtest/gtest.h>
+#include <cstdint>
+
+//Constructors
+TEST(Constructors, constructor) {
+    vector3DArray<double> a(5);
+    EXPECT_EQ(5, a.size());
+
+    vector3DArray<double> b(4, vector3D<double>(1, 2, 3));
+    for (std::size_t i = 0; i < b.size(); ++i) {
+        EXPECT_EQ(1, b[i].x);
+        EXPECT_EQ(2, b[i].y);
+        EXPECT_EQ(3, b[i].z);
+    }
+
+    std::vector<vector3D<double>> aos = {{1, 2, 3}, {4, 5, 6}};
+    vector3DArray<double> c(aos);
+    EXPECT_EQ(2, c.size());
+    EXPECT_EQ(4, c.x()[1]);
+    EXPECT_EQ(5, c.y()[1]);
+    EXPECT_EQ(6, c.z()[1]);
+
+    std::vector<vector3D<double>> back = c.to_vector();
+    EXPECT_EQ(3, back[0].z);
+    EXPECT_EQ(6, back[1].z);
+
+    vector3DArray<double> d(c + c);
+    EXPECT_EQ(8, d[1].x);
+}
+TEST(Storage, alignment) {
+    vector3DArray<double> a(13);
+    EXPECT_EQ(0, reinterpret_cast<std::uintptr_t>(a.x()) % 64);
+    EXPECT_EQ(0, reinterpret_cast<std::uintptr_t>(a.y()) % 64);
+    EXPECT_EQ(0, reinterpret_cast<std::uintptr_t>(a.z()) % 64);
+
+    a.resize(3);
+    EXPECT_EQ(3, a.size());
+    EXPECT_EQ(0, reinterpret_cast<std::uintptr_t>(a.z()) % 64);
+}
+//Element references behave like vector3D
+TEST(Proxy, element_reference) {
+    vector3DArray<double> a(3, vector3D<double>(1, 1, 1));
+    vector3D<double> v(1, 2, 3);
+    a[0] = v;
+    EXPECT_EQ(2, a.y()[0]);
+
+    a[1] += 2 * v;
+    EXPECT_EQ(3, a[1].x);
+    EXPECT_EQ(5, a[1].y);
+    EXPECT_EQ(7, a[1].z);
+
+    a[2].x = 0; a[2][1] = 0; a[2].z = 1;
+    a[2] ^= v;
+    vector3D<double> c = vector3D<double>(0, 0, 1) ^ v;
+    EXPECT_EQ(c.x, a[2].x);
+    EXPECT_EQ(c.y, a[2].y);
+    EXPECT_EQ(c.z, a[2].z);
+
+    a[0] = a[1];
+    EXPECT_EQ(7, a[0].z);
+    EXPECT_EQ(83, a[0] * a[0]);
+    EXPECT_EQ(std::sqrt(83.0), a[0].norm());
+    EXPECT_THROW(a.at(3), std::out_of_range);
+}
+//Whole array expressions
+TEST(Operators, array_expressions) {
+    const std::size_t N = 37;
+    vector3DArray<double> P(N), V(N);
+    for (std::size_t i = 0; i < N; ++i) {
+        P[i].load(i, 2.0 * i, -1.0 * i);
+        V[i].load(1, -1, 0.5);
+    }
+    const double dt = 0.5;
+    P = P + dt * V;
+    for (std::size_t i = 0; i < N; ++i) {
+        EXPECT_EQ(i + 0.5, P[i].x);
+        EXPECT_EQ(2.0 * i - 0.5, P[i].y);
+        EXPECT_EQ(-1.0 * i + 0.25, P[i].z);
+    }
+
+    vector3DArray<double> Q = P;
+    P = P ^ V;
+    for (std::size_t i = 0; i < N; ++i) {
+        vector3D<double> expected = cross(Q[i], V[i]);
+        EXPECT_EQ(expected.x, P[i].x);
+        EXPECT_EQ(expected.y, P[i].y);
+        EXPECT_EQ(expected.z, P[i].z);
+    }
+
+    P = -(Q - V) / 2.0 + ElemProd(Q, V) * 3.0 - Q / V;
+    for (std::size_t i = 0; i < N; ++i) {
+        vector3D<double> expected = -(Q[i] - V[i]) / 2.0 + ElemProd(Q[i], V[i]) * 3.0 - Q[i] / V[i];
+        EXPECT_EQ(expected.x, P[i].x);
+        EXPECT_EQ(expected.y, P[i].y);
+        EXPECT_EQ(expected.z, P[i].z);
+    }
+
+    P = Q;
+    P += V;
+    P -= 2 * V;
+    P *= 2.0;
+    P /= 2.0;
+    for (std::size_t i = 0; i < N; ++i)
+        EXPECT_EQ(Q[i].x - 1, P[i].x);
+
+    vector3DArray<double> R;
+    R = Q + V;
+    EXPECT_EQ(N, R.size());
+    EXPECT_THROW(R += vector3DArray<double>(2), std::length_error);
+
+    // Every operand must have the size of the others, on either side and at any depth
+    vector3DArray<double> S(3);
+    EXPECT_THROW(R = Q + S, std::length_error);
+    EXPECT_THROW(R = S - Q, std::length_error);
+    EXPECT_THROW(R = Q + 2.0 * (V ^ S), std::length_error);
+    EXPECT_THROW(vector3DArray<double>(ElemProd(Q, S)), std::length_error);
+    EXPECT_THROW(R = Q / S, std::length_error);
+    EXPECT_EQ(Q[0].x + V[0].x, R[0].x);
+}
+TEST(Operators, aos_expressions) {
+    const std::size_t N = 37;
+    std::vector<vector3D<double>> A(N), B(N), C(N), E(N);
+    for (std::size_t i = 0; i < N; ++i) {
+        B[i].load(i, 2.0 * i, -1.0 * i);
+        C[i].load(1, -1, 0.5);
+    }
+    const double s = 0.5;
+    aos(A) = aos(B) + s * aos(C);
+    for (std::size_t i = 0; i < N; ++i) {
+        EXPECT_EQ(i + 0.5, A[i].x);
+        EXPECT_EQ(2.0 * i - 0.5, A[i].y);
+        EXPECT_EQ(-1.0 * i + 0.25, A[i].z);
+    }
+    aos(E) = unit(aos(B) + aos(C)) + (aos(B) ^ aos(C)) - ElemProd(aos(A), aos(C)) / 2.0;
+    for (std::size_t i = 0; i < N; ++i) {
+        vector3D<double> expected = unit(B[i] + C[i]) + (B[i] ^ C[i]) - ElemProd(A[i], C[i]) / 2.0;
+        EXPECT_EQ(expected.x, E[i].x);
+        EXPECT_EQ(expected.y, E[i].y);
+        EXPECT_EQ(expected.z, E[i].z);
+    }
+    aos(A) -= aos(C);
+    aos(A) *= 2.0;
+    EXPECT_EQ(2.0 * 4.5, A[5].x);
+    EXPECT_THROW(aos(A) += aos(std::vector<vector3D<double>>(2)), std::length_error);
+    EXPECT_THROW(aos(A).at(N), std::out_of_range);
+
+    // Mixed with structure of arrays
+    vector3DArray<double> P(N);
+    P = aos(B) + 2 * aos(C);
+    EXPECT_EQ(7.0 + 2, P[7].x);
+    aos(A) = P - aos(B);
+    EXPECT_EQ(-2, A[7].y);
+
+    // Fused assignments: the second one sees the values written by the first
+    std::vector<vector3D<double>> F(N);
+    fuse(assign(aos(A), aos(B) + s * aos(C)), assign(aos(F), unit(aos(A))), assign(P, aos(A) + aos(F)));
+    for (std::size_t i = 0; i < N; ++i) {
+        vector3D<double> a = B[i] + s * C[i];
+        vector3D<double> f = unit(a);
+        EXPECT_EQ(a.x, A[i].x);
+        EXPECT_EQ(f.y, F[i].y);
+        EXPECT_EQ(a.z + f.z, P[i].z);
+    }
+    std::vector<vector3D<double>> small(1);
+    EXPECT_THROW(fuse(assign(aos(A), aos(B)), assign(aos(small), aos(C))), std::length_error);
+    EXPECT_THROW(fuse(assign(aos(A), aos(B) + aos(small))), std::length_error);
+    EXPECT_THROW(fuse(assign(aos(A), aos(B)), assign(aos(F), aos(C) - 2.0 * aos(small))), std::length_error);
+    EXPECT_THROW(aos(A) = aos(B) + aos(small), std::length_error);
+    EXPECT_THROW(aos(A) -= unit(aos(small)) + aos(B), std::length_error);
+
+    // Other dimensions
+    std::vector<vector2D<float>> u(N, vector2D<float>(3, 4)), w(N);
+    aos(w) = 2.0f * unit(aos(u));
+    EXPECT_FLOAT_EQ(1.2f, w[N - 1].x);
+    EXPECT_FLOAT_EQ(1.6f, w[0].y);
+    const std::vector<vectorND<int, 4>> k(N, vectorND<int, 4>{1, 2, 3, 4});
+    std::vector<vectorND<int, 4>> l(N);
+    aos(l) = aos(k) * 3 - aos(k);
+    EXPECT_EQ(8, l[3][3]);
+}
+
+int main(int argc, char **argv)
+{
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,136 @@
+/*
+ * This file is part of the Vector3D distribution (https://github.com/cdelv/Vector3D).
+ * Copyright (c) 2022 Carlos Andres del Valle.
+ *
+ *Vector3D is under the terms of the BSD-3 license. We welcome feedback and contributions.
+ *
+ * You should have received a copy of the BSD3 Public License
+ * along with this program. If not, see <https://github.com/cdelv/Vector3D> LICENSE.
+ *
+ *
+ * This library requires C++20.
+ */
+#include "../vector_binary.h"
+#include <gtest/gtest.h>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+
+static std::string temp_file(const std::string &name) {
+    return (std::filesystem::temp_directory_path() / ("vector3d_test_" + name)).string();
+}
+// Overwrites bytes of the header, the way a corrupt or foreign file would have them
+template <typename T>
+static void patch(const std::string &path, const std::size_t offset, const T value) {
+    std::fstream f(path, std::ios::in | std::ios::out | std::ios::binary);
+    f.seekp(offset);
+    f.write(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+TEST(Binary, aos) {
+    const std::string path = temp_file("aos.bin");
+    std::vector<vector3D<double>> v = {{1, 2, 3}, {4, 5, 6}, {-7, 8.5, 9}};
+    write_vectors(path, v);
+    EXPECT_EQ(64 + 3 * sizeof(vector3D<double>), std::filesystem::file_size(path));
+
+    vector_file f(path);
+    EXPECT_EQ(3, f.size());
+    EXPECT_EQ(3, f.dimension());
+    EXPECT_EQ(vector_layout::aos, f.layout());
+    std::span<const vector3D<double>> s = f.aos<vector3D<double>>();
+    ASSERT_EQ(3, s.size());
+    EXPECT_EQ(0, reinterpret_cast<std::uintptr_t>(s.data()) % 64);
+    EXPECT_EQ(8.5, s[2].y);
+    // Usable in expressions without copying
+    vector3D<double> r = s[0] + 2 * s[1] - cross(s[0], s[1]);
+    EXPECT_EQ(12, r.x);
+    EXPECT_EQ(6, r.y);
+    EXPECT_EQ(18, r.z);
+
+    std::vector<vectorND<float, 5>> w(100, vectorND<float, 5>(1, 2, 3, 4, 5));
+    w[99][4] = -1;
+    write_vectors(path, w);
+    vector_file g(path);
+    EXPECT_EQ(-1, (g.aos<vectorND<float, 5>>()[99][4]));
+    std::filesystem::remove(path);
+}
+TEST(Binary, soa) {
+    const std::string path = temp_file("soa.bin");
+    vector3DArray<double> P(13);
+    for (std::size_t i = 0; i < P.size(); ++i)
+        P[i].load(i, 2.0 * i, -1.0 * i);
+    write_vectors(path, P);
+
+    vector_file f(path);
+    EXPECT_EQ(vector_layout::soa, f.layout());
+    vectorArrayView<double, 3> V = f.soa<double, 3>();
+    ASSERT_EQ(13, V.size());
+    EXPECT_EQ(0, reinterpret_cast<std::uintptr_t>(V.x()) % 64);
+    EXPECT_EQ(0, reinterpret_cast<std::uintptr_t>(V.z()) % 64);
+    EXPECT_EQ(24, V.y()[12]);
+    EXPECT_EQ(-5, V[5].z);
+    // The view is an array expression
+    vector3DArray<double> Q = P + 2.0 * V;
+    EXPECT_EQ(36, Q[12].x);
+    EXPECT_EQ(-15, Q[5].z);
+    vector3DArray<double> C(V);
+    EXPECT_EQ(7, C[7].x);
+
+    // AoS written as SoA and back
+    std::vector<vector2D<float>> u = {{1, 2}, {3, 4}, {5, 6}};
+    write_vectors(path, u, vector_layout::soa);
+    vector_file g(path);
+    vectorArrayView<float, 2> U = g.soa<float, 2>();
+    EXPECT_EQ(5, U.x()[2]);
+    EXPECT_EQ(4, U[1].y);
+    write_vectors(path, P, vector_layout::aos);
+    vector_file h(path);
+    EXPECT_EQ(24, h.aos<vector3D<double>>()[12].y);
+    std::filesystem::remove(path);
+}
+TEST(Binary, errors) {
+    const std::string path = temp_file("errors.bin");
+    EXPECT_THROW(vector_file(temp_file("missing.bin")), std::runtime_error);
+
+    std::vector<vector3D<double>> v(10, vector3D<double>(1, 2, 3));
+    write_vectors(path, v);
+    {
+        vector_file f(path);
+        EXPECT_THROW(f.aos<vector3D<float>>(), std::runtime_error);
+        EXPECT_THROW(f.aos<vector2D<double>>(), std::runtime_error);
+        EXPECT_THROW((f.soa<double, 3>()), std::runtime_error);
+    }
+    std::filesystem::resize_file(path, 64 + 9 * sizeof(vector3D<double>));
+    EXPECT_THROW(vector_file{path}, std::runtime_error);
+
+    // A component size that disagrees with the type would let the views read past the file
+    write_vectors(path, vector3DArray<double>(1000));
+    EXPECT_NO_THROW(vector_file{path});
+    patch(path, offsetof(__VectorFileHeader, scalar_bytes), std::uint8_t(1));
+    patch(path, offsetof(__VectorFileHeader, count), std::uint64_t(8000));
+    patch(path, offsetof(__VectorFileHeader, stride), std::uint64_t(8000));
+    EXPECT_THROW(vector_file{path}, std::runtime_error);
+    write_vectors(path, v);
+    patch(path, offsetof(__VectorFileHeader, scalar), std::uint8_t(0));
+    EXPECT_THROW(vector_file{path}, std::runtime_error);
+    // Written on a machine with the other byte order
+    write_vectors(path, v);
+    patch(path, offsetof(__VectorFileHeader, byte_order), std::uint32_t(0x04030201));
+    EXPECT_THROW(vector_file{path}, std::runtime_error);
+
+    std::ofstream(path) << "not a vector file, but long enough to hold a header of sixty-four bytes";
+    EXPECT_THROW(vector_file{path}, std::runtime_error);
+
+    // Empty arrays are fine
+    write_vectors(path, std::vector<vector3D<double>>());
+    EXPECT_EQ(0, vector_file(path).aos<vector3D<double>>().size());
+    write_vectors(path, vector3DArray<float>());
+    EXPECT_EQ(0, (vector_file(path).soa<float, 3>().size()));
+    std::filesystem::remove(path);
+}
+
+int main(int argc, char **argv)
+{
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
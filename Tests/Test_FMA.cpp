@@ -0,0 +1,78 @@
+/*
+ * This file is part of the Vector3D distribution (https://github.com/cdelv/Vector3D).
+ * Copyright (c) 2022 Carlos Andres del Valle.
+ *
+ *Vector3D is under the terms of the BSD-3 license. We welcome feedback and contributions.
+ *
+ * You should have received a copy of the BSD3 Public License
+ * along with this program. If not, see <https://github.com/cdelv/Vector3D> LICENSE.
+ *
+ *
+ * This library requires C++20.
+ */
+// Compiled with -DVECTOR3D_FMA -mfma
+#include "../vector.h"
+#include <gtest/gtest.h>
+
+// a * b = 1 - 2^-54 exactly. Rounded to double it is 1, so a * b - 1 is 0 unless the product is fused.
+const double a = 1 + std::ldexp(1.0, -27);
+const double b = 1 - std::ldexp(1.0, -27);
+const double fused = -std::ldexp(1.0, -54);
+
+TEST(FMA, enabled) {
+    static_assert(__use_fma);
+}
+//Scalar times vector plus vector
+TEST(FMA, scalar_product_sum) {
+    vector3D<double> u(b, b, b), v(-1, -1, -1);
+    vector3D<double> r = a * u + v;
+    EXPECT_EQ(fused, r.x);
+    EXPECT_EQ(fused, r.y);
+    EXPECT_EQ(fused, r.z);
+
+    r = v + u * a;
+    EXPECT_EQ(fused, r.x);
+
+    r = u * a - (-1.0) * v;
+    EXPECT_EQ(fused, r.y);
+
+    r = -v - a * u;
+    EXPECT_EQ(-fused, r.z);
+
+    // Runtime index path
+    auto expr = a * u + v;
+    EXPECT_EQ(fused, expr[1]);
+
+    vector2D<double> p(b, b), q(-1, -1);
+    vector2D<double> s = a * p + q;
+    EXPECT_EQ(fused, s.y);
+}
+//Element-wise product plus vector
+TEST(FMA, element_wise_product_sum) {
+    vectorND<double, 6> u(a), v(b), w(-1.0);
+    vectorND<double, 6> r = ElemProd(u, v) + w;
+    for (std::size_t i = 0; i < 6; ++i)
+        EXPECT_EQ(fused, r[i]);
+}
+//Dot product chain
+TEST(FMA, dot) {
+    vector3D<double> u(1, 1, a), v(-0.5, -0.5, b);
+    EXPECT_EQ(fused, dot(u, v));
+    EXPECT_EQ(fused, u * v);
+}
+//Mixed types and constant evaluation are not fused
+TEST(FMA, fallback) {
+    vector3D<float> u(1, 2, 3);
+    vector3D<double> r = 2.0 * u + u;
+    EXPECT_EQ(9, r.z);
+
+    constexpr vector3D<double> c(1, 2, 3);
+    static_assert(dot(c, c) == 14);
+    static_assert((2.0 * c + c).get<2>() == 9);
+}
+
+int main(int argc, char **argv)
+{
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,136 @@
+/*
+ * This file is part of the Vector3D distribution (https://github.com/cdelv/Vector3D).
+ * Copyright (c) 2022 Carlos Andres del Valle.
+ *
+ *Vector3D is under the terms of the BSD-3 license. We welcome feedback and contributions.
+ *
+ * You should have received a copy of the BSD3 Public License
+ * along with this program. If not, see <https://github.com/cdelv/Vector3D> LICENSE.
+ *
+ *
+ * This library requires C++20.
+ */
+#include "../vector_fastmath.h"
+#include <gtest/gtest.h>
+#include <random>
+
+// Distance between got and the exact value, in ulp of the exact value rounded to T
+template <typename T>
+double ulps(const T got, const long double exact) {
+    const T e = static_cast<T>(exact);
+    const T ulp = std::nextafter(std::abs(e), std::numeric_limits<T>::infinity()) - std::abs(e);
+    return static_cast<double>(std::abs(got - exact) / ulp);
+}
+
+template <typename T>
+class FastMath : public testing::Test {};
+using FloatTypes = testing::Types<float, double>;
+TYPED_TEST_SUITE(FastMath, FloatTypes);
+
+// Documented worst errors in ulp of rsqrt and unit
+template <typename T> constexpr double bound_rsqrt = std::is_same_v<T, float> ? 4 : 3;
+template <typename T> constexpr double bound_unit = std::is_same_v<T, float> ? 6 : 4;
+
+TYPED_TEST(FastMath, rsqrt) {
+    using T = TypeParam;
+    std::mt19937 gen(7);
+    std::uniform_real_distribution<T> mantissa(1, 2);
+    std::uniform_int_distribution<int> exponent(-120, 120);
+    for (int i = 0; i < 100000; ++i) {
+        const T x = std::ldexp(mantissa(gen), exponent(gen));
+        EXPECT_LE(ulps(fastmath::rsqrt(x), 1.0L / std::sqrt(static_cast<long double>(x))), bound_rsqrt<T>) << x;
+    }
+    // Every float in [1, 4), where the error repeats with period 4 in x, and at the ends of the normal
+    // range, where x / 2 is subnormal or x y^2 could overflow
+    if constexpr (std::is_same_v<T, float>) {
+        const std::uint32_t min = std::bit_cast<std::uint32_t>(std::numeric_limits<T>::min());
+        const std::uint32_t max = std::bit_cast<std::uint32_t>(std::numeric_limits<T>::max());
+        const std::uint32_t one = std::bit_cast<std::uint32_t>(T(1));
+        const std::uint32_t binades = 2u << 23;
+        double worst = 0;
+        T at = 0;
+        for (const std::uint32_t first : {one, min, max + 1 - binades})
+            for (std::uint32_t b = first; b < first + binades; ++b) {
+                const T x = std::bit_cast<T>(b);
+                const double e = ulps(fastmath::rsqrt(x), 1.0L / std::sqrt(static_cast<long double>(x)));
+                if (e > worst) {
+                    worst = e;
+                    at = x;
+                }
+            }
+        EXPECT_LE(worst, bound_rsqrt<T>) << at;
+    }
+    // Outside the range of the fast path
+    EXPECT_EQ(std::numeric_limits<T>::infinity(), fastmath::rsqrt(T(0)));
+    EXPECT_EQ(T(0), fastmath::rsqrt(std::numeric_limits<T>::infinity()));
+    const T tiny = std::numeric_limits<T>::denorm_min();
+    EXPECT_EQ(T(1) / std::sqrt(tiny), fastmath::rsqrt(tiny));
+    static_assert(fastmath::rsqrt(T(4)) == T(0.5));
+}
+TYPED_TEST(FastMath, acos) {
+    using T = TypeParam;
+    for (int i = -10000; i <= 10000; ++i) {
+        const T x = T(i) / 10000;
+        const long double exact = std::acos(static_cast<long double>(x));
+        if constexpr (std::is_same_v<T, float>)
+            EXPECT_LE(ulps(fastmath::acos(x), exact), 3) << x;
+        else
+            EXPECT_LE(std::abs(fastmath::acos(x) - exact), 2.2e-8) << x;
+    }
+    EXPECT_EQ(T(0), fastmath::acos(T(1)));
+    EXPECT_EQ(T(0), fastmath::acos(T(1) + std::numeric_limits<T>::epsilon()));
+    EXPECT_NEAR(M_PI, fastmath::acos(T(-1)), 1e-6);
+}
+TYPED_TEST(FastMath, unit) {
+    using T = TypeParam;
+    std::mt19937 gen(3);
+    std::uniform_real_distribution<T> c(-100, 100);
+    for (int i = 0; i < 100000; ++i) {
+        vector3D<T> v(c(gen), c(gen), c(gen));
+        const long double n = std::sqrt(static_cast<long double>(v.x) * v.x + static_cast<long double>(v.y) * v.y + static_cast<long double>(v.z) * v.z);
+        vector3D<T> u = fastmath::unit(v);
+        EXPECT_LE(ulps(u.x, v.x / n), bound_unit<T>);
+        EXPECT_LE(ulps(u.y, v.y / n), bound_unit<T>);
+        EXPECT_LE(ulps(u.z, v.z / n), bound_unit<T>);
+        fastmath::normalize(v);
+        EXPECT_EQ(u.x, v.x);
+        EXPECT_EQ(u.z, v.z);
+    }
+    // Costly operands are evaluated once
+    vector3D<T> a(1, 2, 3), b(4, 5, 6);
+    static_assert(__cost_v<decltype(fastmath::unit(a + b))> == 1);
+    vector3D<T> r = fastmath::unit(a + b), s = unit(a + b);
+    EXPECT_NEAR(s.x, r.x, 8 * std::numeric_limits<T>::epsilon());
+    EXPECT_NEAR(s.y, r.y, 8 * std::numeric_limits<T>::epsilon());
+
+    vectorND<T, 5> w(3, 0, 4, 0, 0);
+    vectorND<T, 5> q = fastmath::unit(w);
+    EXPECT_NEAR(0.6, q[0], 8 * std::numeric_limits<T>::epsilon());
+    EXPECT_NEAR(0.8, q[2], 8 * std::numeric_limits<T>::epsilon());
+}
+TYPED_TEST(FastMath, division) {
+    using T = TypeParam;
+    vector3D<T> v(1, -2, 3);
+    const T a = 3;
+    vector3D<T> r = fastmath::div(v, a);
+    EXPECT_LE(ulps(r.x, 1.0L / 3), 1.5);
+    EXPECT_LE(ulps(r.y, -2.0L / 3), 1.5);
+    EXPECT_EQ(T(1), r.z);
+}
+TYPED_TEST(FastMath, angle) {
+    using T = TypeParam;
+    vector3D<T> x(1, 0, 0), y(0, 2, 0), d(1, 1, 0);
+    EXPECT_NEAR(M_PI / 2, fastmath::angle(x, y), 1e-6);
+    EXPECT_NEAR(M_PI / 4, fastmath::angle(x, d), 1e-6);
+    EXPECT_NEAR(45, fastmath::angled(x, d), 1e-4);
+    // Parallel vectors do not give NaN. A cosine a few ulp away from 1 moves acos by about sqrt(eps).
+    const T tol = std::sqrt(16 * std::numeric_limits<T>::epsilon());
+    EXPECT_NEAR(0, fastmath::angle(d, T(3) * d), tol);
+    EXPECT_NEAR(M_PI, fastmath::angle(d, -d), tol);
+}
+
+int main(int argc, char **argv)
+{
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
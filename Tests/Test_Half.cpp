@@ -0,0 +1,162 @@
+/*
+ * This file is part of the Vector3D distribution (https://github.com/cdelv/Vector3D).
+ * Copyright (c) 2022 Carlos Andres del Valle.
+ *
+ *Vector3D is under the terms of the BSD-3 license. We welcome feedback and contributions.
+ *
+ * You should have received a copy of the BSD3 Public License
+ * along with this program. If not, see <https://github.com/cdelv/Vector3D> LICENSE.
+ *
+ *
+ * This library requires C++20.
+ */
+#include "../vector_half.h"
+#include <gtest/gtest.h>
+#include <cmath>
+#include <limits>
+#include <random>
+
+// Random floats of every magnitude, and the special values
+static std::vector<float> test_floats(const std::size_t n) {
+    std::default_random_engine gen(3);
+    std::uniform_int_distribution<std::uint32_t> bits;
+    std::vector<float> f(n);
+    for (float &x : f)
+        x = std::bit_cast<float>(bits(gen));
+    const float special[] = {0.0f, -0.0f, 1.0f, 65504.0f, 65519.0f, 65520.0f, 1e-8f, 5.9604645e-8f, 2.9802322e-8f, 2.9802326e-8f,
+                             6.1035156e-5f, std::numeric_limits<float>::infinity(), -std::numeric_limits<float>::infinity(),
+                             std::numeric_limits<float>::quiet_NaN(), std::numeric_limits<float>::max(), std::numeric_limits<float>::denorm_min()};
+    std::copy(std::begin(special), std::end(special), f.begin());
+    return f;
+}
+
+TEST(Half, conversions) {
+    // Exact values and rounding to nearest even
+    EXPECT_EQ(0x3c00, float16(1.0f).bits());
+    EXPECT_EQ(0xc000, float16(-2).bits());
+    EXPECT_EQ(0x7bff, float16(65504.0).bits());
+    EXPECT_EQ(0x7bff, float16(65519.0f).bits());
+    EXPECT_EQ(0x7c00, float16(65520.0f).bits());
+    EXPECT_EQ(0x0001, float16(5.9604645e-8f).bits());
+    EXPECT_EQ(0x0000, float16(2.9802322e-8f).bits());
+    EXPECT_EQ(0x0001, float16(2.9802326e-8f).bits());
+    EXPECT_EQ(0x3c00, float16(1.0f + 0x1p-11f).bits());
+    EXPECT_EQ(0x3c02, float16(1.0f + 3 * 0x1p-11f).bits());
+    EXPECT_TRUE(std::isnan(float(float16(std::nanf("")))));
+    EXPECT_EQ(0.099975586f, float(float16(0.1f)));
+    EXPECT_EQ(0x3f80, bfloat16(1.0f).bits());
+    EXPECT_EQ(0x3f80, bfloat16(1.0f + 0x1p-8f).bits());
+    EXPECT_EQ(0x3f82, bfloat16(1.0f + 3 * 0x1p-8f).bits());
+    EXPECT_EQ(3.3895314e38f, float(bfloat16(3.3895314e38f)));
+    EXPECT_TRUE(std::isinf(float(bfloat16(std::numeric_limits<float>::max()))));
+    EXPECT_TRUE(std::isnan(float(bfloat16(std::nanf("")))));
+    // From double and integers in one rounding, not through a float rounded to nearest
+    EXPECT_EQ(0x3c01, float16(1.0 + 0x1p-11 + 0x1p-40).bits());
+    EXPECT_EQ(0xbc01, float16(-1.0 - 0x1p-11 - 0x1p-40).bits());
+    EXPECT_EQ(0x3c00, float16(1.0 + 0x1p-11).bits());
+    EXPECT_EQ(0x3f81, bfloat16(1.0 + 0x1p-8 + 0x1p-40).bits());
+    EXPECT_EQ(0x0001, float16(0x1p-25 + 0x1p-60).bits());
+    EXPECT_EQ(0x0000, float16(1e-300).bits());
+    EXPECT_EQ(0x8000, float16(-1e-300).bits());
+    EXPECT_EQ(0x7c00, float16(1e300).bits());
+    EXPECT_EQ(0xff80, bfloat16(-1e300).bits());
+    EXPECT_TRUE(std::isnan(float(float16(std::nan("")))));
+    EXPECT_EQ(0x4b81, bfloat16(std::int64_t(0x1010001)).bits());
+    EXPECT_EQ(0xcb81, bfloat16(-0x1010001).bits());
+    EXPECT_EQ(0x4b80, bfloat16(0x1010000u).bits());
+    static_assert(float16(1.0 + 0x1p-11 + 0x1p-40).bits() == 0x3c01);
+
+    // Every float16 converts to float and back to itself
+    for (std::uint32_t b = 0; b < 0x10000; ++b) {
+        const float16 h = float16::from_bits(static_cast<std::uint16_t>(b));
+        const float16 back = float(h);
+        if (std::isnan(float(h))) EXPECT_TRUE(std::isnan(float(back)));
+        else EXPECT_EQ(h.bits(), back.bits()) << b;
+        const bfloat16 g = bfloat16::from_bits(static_cast<std::uint16_t>(b));
+        const bfloat16 g_back = float(g);
+        if (std::isnan(float(g))) EXPECT_TRUE(std::isnan(float(g_back)));
+        else EXPECT_EQ(g.bits(), g_back.bits()) << b;
+    }
+    static_assert(float16(2.5f).bits() == 0x4100 && float(float16::from_bits(0x4100)) == 2.5f);
+    static_assert(bfloat16(-2.5f).bits() == 0xc020);
+}
+TEST(Half, vectors) {
+    vector3D<float16> a(1, 2, 3), b(0.5, -1, 2);
+    // Expressions evaluate in float
+    auto c = eval(a + 2 * b);
+    static_assert(std::is_same_v<decltype(c), vector3D<float>>);
+    EXPECT_EQ(2, c.x);
+    EXPECT_EQ(0, c.y);
+    EXPECT_EQ(7, c.z);
+    static_assert(std::is_same_v<decltype(dot(a, b)), float>);
+    EXPECT_EQ(4.5f, dot(a, b));
+    EXPECT_FLOAT_EQ(std::sqrt(14.0f), norm(a));
+    vector3D<float16> d = a ^ b;
+    EXPECT_EQ(7, d.x);
+    EXPECT_EQ(-0.5, d.y);
+    d += a;
+    d *= 2;
+    EXPECT_EQ(16, d.x);
+
+    // Sums beyond the range and precision of float16 are kept in float
+    vectorND<float16, 8> big(float16(300.0f));
+    EXPECT_EQ(8 * 300.0f * 300.0f, norm2(big));
+    vectorND<float16, 8> small(float16(1.0f + 0x1p-10f));
+    EXPECT_EQ(8 * (1.0f + 0x1p-10f), sum(small));
+    // Storing rounds
+    vector2D<float16> r = vector2D<float>(1.0f / 3, 65519.0f);
+    EXPECT_EQ(float(float16(1.0f / 3)), r.x);
+    EXPECT_EQ(65504, r.y);
+
+    vector3D<bfloat16> e(1, 2, 3);
+    EXPECT_EQ(14, norm2(e));
+    vector3D<bfloat16> f = e * 1e30;
+    EXPECT_NEAR(3e30, f.z, 3e30 / 128);
+}
+TEST(Half, batch) {
+    const std::vector<float> f = test_floats(1003);
+    std::vector<float16> h(f.size()), h_scalar(f.size());
+    std::vector<bfloat16> b(f.size());
+    std::vector<float> back(f.size());
+    const simd_isa initial = batch_isa();
+    for (const simd_isa isa : {simd_isa::scalar, simd_isa::sse42, simd_isa::avx2, simd_isa::avx512}) {
+        if (!set_batch_isa(isa)) continue;
+        batch_convert(f.data(), h.data(), f.size());
+        batch_convert(f.data(), b.data(), f.size());
+        for (std::size_t i = 0; i < f.size(); ++i) {
+            EXPECT_EQ(float16(f[i]).bits(), h[i].bits()) << simd_isa_name(isa) << " " << f[i];
+            EXPECT_EQ(bfloat16(f[i]).bits(), b[i].bits()) << simd_isa_name(isa) << " " << f[i];
+        }
+        batch_convert(h.data(), back.data(), h.size());
+        for (std::size_t i = 0; i < f.size(); ++i)
+            EXPECT_EQ(std::bit_cast<std::uint32_t>(float(h[i])), std::bit_cast<std::uint32_t>(back[i])) << simd_isa_name(isa);
+        batch_convert(b.data(), back.data(), b.size());
+        for (std::size_t i = 0; i < f.size(); ++i)
+            EXPECT_EQ(std::bit_cast<std::uint32_t>(float(b[i])), std::bit_cast<std::uint32_t>(back[i])) << simd_isa_name(isa);
+    }
+    set_batch_isa(initial);
+
+    // Arrays of vectors
+    std::vector<vector3D<float>> v(101), w(101);
+    for (std::size_t i = 0; i < v.size(); ++i)
+        v[i].load(i, -0.5f * i, 1.0f / (i + 1));
+    std::vector<vector3D<float16>> v16(v.size());
+    std::vector<vector3D<bfloat16>> vb(v.size());
+    batch_convert(v.data(), v16.data(), v.size());
+    batch_convert(v.data(), vb.data(), v.size());
+    batch_convert(v16.data(), w.data(), w.size());
+    EXPECT_EQ(float(float16(1.0f / 51)), w[50].z);
+    EXPECT_EQ(-50, w[100].y);
+    batch_convert(vb.data(), w.data(), w.size());
+    EXPECT_EQ(float(bfloat16(1.0f / 51)), w[50].z);
+    std::vector<vectorND<float16, 5>> n16(3, vectorND<float16, 5>(float16(2.0f)));
+    std::vector<vectorND<float, 5>> n32(3);
+    batch_convert(n16.data(), n32.data(), 3);
+    EXPECT_EQ(2, n32[2][4]);
+}
+
+int main(int argc, char **argv)
+{
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
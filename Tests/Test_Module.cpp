@@ -0,0 +1,45 @@
+/*
+ * This file is part of the Vector3D distribution (https://github.com/cdelv/Vector3D).
+ * Copyright (c) 2022 Carlos Andres del Valle.
+ *
+ *Vector3D is under the terms of the BSD-3 license. We welcome feedback and contributions.
+ *
+ * You should have received a copy of the BSD3 Public License
+ * along with this program. If not, see <https://github.com/cdelv/Vector3D> LICENSE.
+ *
+ *
+ * This library requires C++20.
+ */
+#include <gtest/gtest.h>
+#include <cmath>
+
+// Computed in Module_import.cpp, which imports the module instead of including vector.h
+void module_results(double *r);
+
+// The module exports the same API as the header
+TEST(Module, import) {
+    double r[16];
+    module_results(r);
+    EXPECT_EQ(12, r[0]);
+    EXPECT_EQ(6, r[1]);
+    EXPECT_EQ(18, r[2]);
+    EXPECT_EQ(32, r[3]);
+    EXPECT_EQ(32, r[4]);
+    EXPECT_DOUBLE_EQ(std::sqrt(14.0), r[5]);
+    EXPECT_DOUBLE_EQ(1, r[6]);
+    EXPECT_NEAR(0, r[7], 1e-7);
+    EXPECT_EQ(-3, r[8]);
+    EXPECT_DOUBLE_EQ(1, r[9]);
+    EXPECT_EQ(2, r[10]);
+    EXPECT_FLOAT_EQ(5, r[11]);
+    EXPECT_EQ(3, r[12]);
+    EXPECT_EQ(4.5, r[13]);
+    EXPECT_EQ(15, r[14]);
+    EXPECT_EQ(55, r[15]);
+}
+
+int main(int argc, char **argv)
+{
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
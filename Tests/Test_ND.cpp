@@ -0,0 +1,155 @@
+/*
+ * This file is part of the Vector3D distribution (https://github.com/cdelv/Vector3D).
+ * Copyright (c) 2022 Carlos Andres del Valle.
+ *
+ *Vector3D is under the terms of the BSD-3 license. We welcome feedback and contributions.
+ *
+ * You should have received a copy of the BSD3 Public License
+ * along with this program. If not, see <https://github.com/cdelv/Vector3D> LICENSE.
+ *
+ *
+ * This library requires C++20.
+ */
+#include "../vector.h"
+#include <gtest/gtest.h>
+#include <numeric>
+
+// Defaults of the accumulation policies for two types that no other test uses
+template <> struct accumulation_policy<long double> { using type = kahan_sum; };
+template <> struct accumulation_policy<short> { using type = widened_sum; };
+
+//Storage
+TEST(Storage, inline_storage) {
+    // The components live inside the object, copies are plain memory copies.
+    static_assert(std::is_trivially_copyable_v<vectorND<double, 6>>);
+    static_assert(sizeof(vectorND<double, 6>) == 6 * sizeof(double));
+    static_assert(sizeof(vectorND<double, 9>) == 9 * sizeof(double));
+    static_assert(alignof(vectorND<double, 6>) == 16);
+    static_assert(alignof(vectorND<double, 8>) == 64);
+    static_assert(alignof(vectorND<float, 3>) == alignof(float));
+
+    vectorND<double, 9> v(1.5);
+    vectorND<double, 9> u(v);
+    u[0] = 2;
+    EXPECT_EQ(1.5, v[0]);
+    EXPECT_EQ(2, u[0]);
+}
+//Constructors
+TEST(Constructors, constructor) {
+    vectorND<double, 6> a(0);
+    for (std::size_t i = 0; i < 6; ++i)
+        EXPECT_EQ(0.0, a[i]);
+
+    vectorND<double, 6> b(1, 2, 3, 4, 5, 6);
+    for (std::size_t i = 0; i < 6; ++i)
+        EXPECT_EQ(i + 1, b[i]);
+
+    vectorND<double, 6> c(a + b);
+    for (std::size_t i = 0; i < 6; ++i)
+        EXPECT_EQ(i + 1, c[i]);
+
+    vectorND<int, 4> d = {1, 2, 3, 4};
+    EXPECT_EQ(4, d[3]);
+
+    c = b - 2 * b;
+    for (std::size_t i = 0; i < 6; ++i)
+        EXPECT_EQ(-double(i + 1), c[i]);
+}
+//Initialize the vector
+TEST(Initialization, load) {
+    vectorND<double, 6> v;
+    v.load(1, 2.7, -0.2, 1e8, 1e-8, 0);
+    EXPECT_EQ(1.0, v[0]);
+    EXPECT_EQ(2.7, v[1]);
+    EXPECT_EQ(-0.2, v[2]);
+    EXPECT_EQ(1e8, v[3]);
+    EXPECT_EQ(1e-8, v[4]);
+    EXPECT_EQ(0, v[5]);
+}
+//Iterators
+TEST(Iterators, begin_end) {
+    vectorND<double, 9> v(1, 2, 3, 4, 5, 6, 7, 8, 9);
+    EXPECT_EQ(45, std::accumulate(v.begin(), v.end(), 0.0));
+
+    std::fill(v.begin(), v.end(), 2.0);
+    const vectorND<double, 9>& w = v;
+    EXPECT_EQ(18, std::accumulate(w.begin(), w.end(), 0.0));
+}
+//Operators
+TEST(Operators, compound_assignment) {
+    vectorND<double, 6> v(1, 2, 3, 4, 5, 6);
+    vectorND<double, 6> u(1.0);
+    v += u + u;
+    EXPECT_EQ(3, v[0]);
+    EXPECT_EQ(8, v[5]);
+    v -= u;
+    EXPECT_EQ(2, v[0]);
+    v *= 2;
+    EXPECT_EQ(4, v[0]);
+    v /= 4;
+    EXPECT_EQ(1, v[0]);
+    v /= 2 * u;
+    EXPECT_EQ(0.5, v[0]);
+    EXPECT_EQ(1.75, v[5]);
+}
+TEST(Functions, reductions) {
+    vectorND<double, 6> v(1, 2, 3, 4, 5, 6);
+    EXPECT_EQ(21, sum(v));
+    EXPECT_EQ(91, dot(v, v));
+    EXPECT_EQ(91, v.norm2());
+    EXPECT_EQ(std::sqrt(91), norm(v));
+    EXPECT_DOUBLE_EQ(1, norm(unit(v)));
+}
+TEST(Functions, accumulation_policies) {
+    // A large first term and many small ones: float loses every small one
+    vectorND<float, 1001> v(1.0f);
+    v[0] = 1e8f;
+    EXPECT_EQ(1e8f, sum(v));
+    EXPECT_EQ(1e8f, sum(v, naive_sum()));
+    EXPECT_EQ(1e8 + 1000, sum(v, widened_sum()));
+    EXPECT_EQ(1e8f + 1000, sum(v, kahan_sum()));
+    EXPECT_NEAR(1e8 + 1000, sum(v, pairwise_sum()), 8);
+    static_assert(std::is_same_v<decltype(sum(v, widened_sum())), double>);
+    static_assert(std::is_same_v<decltype(sum(v, kahan_sum())), float>);
+
+    // The products are taken in double too
+    vectorND<float, 4> a(1 + 0x1p-20f, 3, 1, 1), b(1 + 0x1p-20f, 5, -16, 1);
+    EXPECT_EQ((1 + 0x1p-20) * (1 + 0x1p-20) + 15 - 16 + 1, dot(a, b, widened_sum()));
+    EXPECT_EQ(dot(a, b), dot(a, b, naive_sum()));
+    EXPECT_EQ(dot(a + b, b, kahan_sum()), dot(eval(a + b), b, kahan_sum()));
+    vectorND<std::complex<double>, 3> c(std::complex<double>(1e17, -1e17), std::complex<double>(1, 1), std::complex<double>(-1e17, 1e17));
+    EXPECT_EQ(std::complex<double>(1, 1), sum(c, kahan_sum()));
+    EXPECT_EQ(std::complex<double>(0, 0), sum(c, pairwise_sum()));    // up to 8 terms in order
+    vectorND<int, 3> k(2000000000, 2000000000, 1);
+    EXPECT_EQ(4000000001LL, sum(k, widened_sum()));
+
+    // Defaults per type
+    vectorND<long double, 100> l(1.0L);
+    l[0] = 1e20L;
+    EXPECT_EQ(1e20L + 99, sum(l));
+    EXPECT_EQ(1e20L, sum(l, naive_sum()));
+    vectorND<short, 3> s(30000, 30000, 30000);
+    static_assert(std::is_same_v<decltype(sum(s)), long long>);
+    EXPECT_EQ(90000, sum(s));
+    static_assert(sum(vectorND<double, 3>(1, 2, 3), kahan_sum()) == 6);
+}
+//Compile time access
+TEST(Compile_time_access, get) {
+    vectorND<double, 6> v(1, 2, 3, 4, 5, 6);
+    EXPECT_EQ(1, v.get<0>());
+    EXPECT_EQ(6, v.get<5>());
+    v.get<5>() = 7;
+    EXPECT_EQ(7, v[5]);
+    EXPECT_EQ(2 * v[3] - 1, (2 * v - 1.0 * vectorND<double, 6>(1.0)).get<3>());
+
+    // Above the unroll limit the components are assigned in a loop
+    vectorND<double, 40> w(1.0);
+    vectorND<double, 40> z(w + w);
+    EXPECT_EQ(80, sum(z));
+}
+
+int main(int argc, char **argv)
+{
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,142 @@
+/*
+ * This file is part of the Vector3D distribution (https://github.com/cdelv/Vector3D).
+ * Copyright (c) 2022 Carlos Andres del Valle.
+ *
+ *Vector3D is under the terms of the BSD-3 license. We welcome feedback and contributions.
+ *
+ * You should have received a copy of the BSD3 Public License
+ * along with this program. If not, see <https://github.com/cdelv/Vector3D> LICENSE.
+ *
+ *
+ * This library requires C++20.
+ */
+#include "../vector_parallel.h"
+#include "../vector_array.h"
+#include "../vector_reduce.h"
+#include <gtest/gtest.h>
+#include <cmath>
+
+TEST(Parallel, pool) {
+    EXPECT_GE(thread_pool::global().size(), 1);
+    thread_pool one(1), four(4);
+    EXPECT_EQ(1, one.size());
+    EXPECT_EQ(4, four.size());
+
+    // Every part runs once, part 0 on the calling thread
+    for (thread_pool* pool : {&one, &four}) {
+        std::vector<std::atomic<int>> runs(20);
+        std::thread::id first;
+        pool->run(runs.size(), [&](const std::size_t p) {
+            if (p == 0) first = std::this_thread::get_id();
+            runs[p]++;
+        });
+        for (const auto &r : runs)
+            EXPECT_EQ(1, r.load());
+        EXPECT_EQ(std::this_thread::get_id(), first);
+    }
+
+    // Exceptions reach the caller, and the pool keeps working
+    EXPECT_THROW(four.run(8, [](const std::size_t p) {
+        if (p == 5) throw std::runtime_error("part 5");
+    }), std::runtime_error);
+    std::atomic<int> count{0};
+    four.run(8, [&](std::size_t) { count++; });
+    EXPECT_EQ(8, count.load());
+}
+TEST(Parallel, parallel_for) {
+    thread_pool pool(4);
+    for (const std::size_t n : {0, 1, 7, 1000, 100003})
+        for (const std::size_t grain : {1, 3, 64, 1 << 20}) {
+            parallel_options o;
+            o.grain = grain;
+            o.pool = &pool;
+            // Every index once, with more work on some of them
+            std::vector<int> hits(n, 0);
+            std::atomic<std::size_t> chunks{0};
+            parallel_for(n, [&](const std::size_t begin, const std::size_t end) {
+                EXPECT_LE(end - begin, grain);
+                chunks++;
+                for (std::size_t i = begin; i < end; ++i) {
+                    double x = 0;
+                    for (std::size_t k = 0; k < (i % 97 == 0 ? 1000 : 1); ++k)
+                        x += std::sqrt(double(k));
+                    hits[i] += 1 + (x < 0);
+                }
+            }, o);
+            EXPECT_EQ(std::vector<int>(n, 1), hits) << n << " " << grain;
+            EXPECT_GE(chunks.load(), (n + grain - 1) / grain);
+        }
+
+    // Nested loops share the workers
+    std::vector<std::vector<int>> grid(16, std::vector<int>(1000, 0));
+    parallel_options outer, inner;
+    outer.grain = 1;
+    outer.pool = inner.pool = &pool;
+    inner.grain = 10;
+    parallel_for(grid.size(), [&](const std::size_t begin, const std::size_t end) {
+        for (std::size_t r = begin; r < end; ++r)
+            parallel_for(grid[r].size(), [&](const std::size_t b, const std::size_t e) {
+                for (std::size_t c = b; c < e; ++c)
+                    grid[r][c] = int(r * c);
+            }, inner);
+    }, outer);
+    EXPECT_EQ(15 * 999, grid[15][999]);
+    EXPECT_EQ(3 * 7, grid[3][7]);
+
+    parallel_options failing;
+    failing.grain = 10;
+    failing.pool = &pool;
+    EXPECT_THROW(parallel_for(1000, [](const std::size_t begin, std::size_t) {
+        if (begin == 500) throw std::out_of_range("500");
+    }, failing), std::out_of_range);
+}
+TEST(Parallel, transform) {
+    thread_pool pool(3);
+    parallel_options o;
+    o.grain = 100;
+    o.pool = &pool;
+    const std::size_t n = 10000;
+    std::vector<vector3D<double>> V1(n), V2(n), V3(n);
+    parallel_for_each(V1, [](vector3D<double> &v) { v.load(1, 2, 3); }, o);
+    for (std::size_t i = 0; i < n; ++i)
+        V2[i].load(i, 0, -1.0 * i);
+
+    // An expression per element, evaluated into the output
+    parallel_transform(V1, V2, V3, [](const auto &a, const auto &b) { return eval(a + (b ^ a)); }, o);
+    for (const std::size_t i : {std::size_t(0), std::size_t(77), n - 1}) {
+        const vector3D<double> e = V1[i] + (V2[i] ^ V1[i]);
+        EXPECT_EQ(e.x, V3[i].x);
+        EXPECT_EQ(e.y, V3[i].y);
+        EXPECT_EQ(e.z, V3[i].z);
+    }
+
+    // Structure of arrays, and other dimensions
+    vector3DArray<double> P(V2), Q(n);
+    parallel_transform(P, Q, [](const auto &p) { return 2 * p; }, o);
+    EXPECT_EQ(2.0 * 77, Q[77].x);
+    EXPECT_EQ(-2.0 * 77, Q[77].z);
+    parallel_transform(P, Q, Q, [](const auto &p, const auto &q) { return p + q; }, o);
+    EXPECT_EQ(3.0 * 77, Q[77].x);
+    parallel_assign(Q, P + 2 * Q, o);
+    EXPECT_EQ(7.0 * 77, Q[77].x);
+    EXPECT_EQ(-7.0 * 77, Q[77].z);
+    std::vector<vector2D<float>> u(n, vector2D<float>(3, 4));
+    std::vector<float> norms(n);
+    parallel_transform(u, norms, [](const auto &v) { return v.norm(); }, o);
+    EXPECT_EQ(5, norms[n - 1]);
+    std::vector<float> small(1);
+    EXPECT_THROW(parallel_transform(u, small, [](const auto &v) { return v.norm(); }, o), std::length_error);
+
+    // The reductions run on the same pools
+    reduce_options r;
+    r.grain = 10;
+    r.pool = &pool;
+    const vector3D<double> s = parallel_sum(V1, r);
+    EXPECT_EQ(3.0 * n, s.z);
+}
+
+int main(int argc, char **argv)
+{
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
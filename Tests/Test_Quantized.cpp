@@ -0,0 +1,112 @@
+/*
+ * This file is part of the Vector3D distribution (https://github.com/cdelv/Vector3D).
+ * Copyright (c) 2022 Carlos Andres del Valle.
+ *
+ *Vector3D is under the terms of the BSD-3 license. We welcome feedback and contributions.
+ *
+ * You should have received a copy of the BSD3 Public License
+ * along with this program. If not, see <https://github.com/cdelv/Vector3D> LICENSE.
+ *
+ *
+ * This library requires C++20.
+ */
+#include "../vector_quantized.h"
+#include <gtest/gtest.h>
+#include <random>
+
+static vector3DArray<double> random_positions(const std::size_t n) {
+    std::default_random_engine gen(5);
+    std::uniform_real_distribution<double> rand(-10.0, 10.0);
+    vector3DArray<double> P(n);
+    for (std::size_t i = 0; i < n; ++i)
+        P[i].load(rand(gen), 0.5 * rand(gen), 3 + rand(gen));
+    return P;
+}
+
+TEST(Quantized, error_bound) {
+    const vector3DArray<double> P = random_positions(1001);
+    const vector3D<double> lower(-10, -5, -7), upper(10, 5, 13);
+    quantized16_3DArray<double> Q16(P, lower, upper);
+    quantized32_3DArray<double> Q32(P, lower, upper);
+    EXPECT_EQ(1001, Q16.size());
+    EXPECT_DOUBLE_EQ(20.0 / 65535, Q16.step().x);
+    EXPECT_DOUBLE_EQ(5.0 / 65535, Q16.max_error().y);
+    EXPECT_DOUBLE_EQ(13, Q16.upper().z);
+    EXPECT_EQ(0, reinterpret_cast<std::uintptr_t>(Q16.z()) % 64);
+
+    const vector3D<double> e16 = Q16.max_error(), e32 = Q32.max_error();
+    for (std::size_t i = 0; i < P.size(); ++i)
+        for (std::size_t k = 0; k < 3; ++k) {
+            EXPECT_LE(std::abs(Q16[i][k] - P[i][k]), e16[k] * (1 + 1e-9));
+            EXPECT_LE(std::abs(Q32[i][k] - P[i][k]), e32[k] * (1 + 1e-6));
+        }
+    // The corners of the box are exact
+    Q16.set(0, lower);
+    Q16.set(1, vector3D<double>(upper));
+    EXPECT_EQ(-10, Q16[0].x);
+    EXPECT_EQ(0, Q16.x()[0]);
+    EXPECT_EQ(65535, Q16.z()[1]);
+    EXPECT_DOUBLE_EQ(13, Q16[1].z);
+    // Outside the box, clamped
+    Q16.set(2, vector3D<double>(-100, 100, std::nan("")));
+    EXPECT_EQ(-10, Q16[2].x);
+    EXPECT_DOUBLE_EQ(5, Q16[2].y);
+    EXPECT_EQ(-7, Q16[2].z);
+}
+TEST(Quantized, resolution_and_fit) {
+    const vector3DArray<double> P = random_positions(500);
+    // A step of 1e-3 from the origin of the box
+    quantized16_3DArray<double> Q(P, vector3D<double>(-10, -10, -10), 1e-3);
+    EXPECT_DOUBLE_EQ(-10 + 65.535, Q.upper().y);
+    for (std::size_t i = 0; i < P.size(); ++i)
+        EXPECT_LE(norm(Q[i] - P[i]), std::sqrt(3.0) * 0.5e-3 * (1 + 1e-9));
+
+    quantized16_3DArray<double> F = quantized16_3DArray<double>::fit(P);
+    for (std::size_t k = 0; k < 3; ++k) {
+        const double* c = k == 0 ? P.x() : k == 1 ? P.y() : P.z();
+        EXPECT_EQ(*std::min_element(c, c + P.size()), F.lower()[k]);
+        EXPECT_DOUBLE_EQ(*std::max_element(c, c + P.size()), F.upper()[k]);
+    }
+    vector3DArray<double> flat(3, vector3D<double>(1, 2, 3));
+    EXPECT_EQ(2, quantized16_3DArray<double>::fit(flat)[1].y);
+
+    EXPECT_THROW(quantized16_3DArray<double>(3, vector3D<double>(0, 0, 0), vector3D<double>(1, 0, 1)), std::invalid_argument);
+    EXPECT_THROW(quantized16_3DArray<double>(3, vector3D<double>(0, 0, 0), -1.0), std::invalid_argument);
+    EXPECT_THROW(Q.at(500), std::out_of_range);
+}
+TEST(Quantized, batch_and_expressions) {
+    const vector3DArray<double> P = random_positions(777);
+    vector3DArray<double> V(777, vector3D<double>(0.5, -0.25, 1));
+    quantized16_3DArray<double> Q(777, vector3D<double>(-20, -20, -20), vector3D<double>(20, 20, 20));
+    Q.encode(P);
+    quantized16_3DArray<double> R(P, Q.lower(), Q.upper());
+    EXPECT_TRUE(std::equal(Q.x(), Q.x() + 777, R.x()));
+    EXPECT_TRUE(std::equal(Q.z(), Q.z() + 777, R.z()));
+
+    vector3DArray<double> D = Q.decode();
+    for (std::size_t i = 0; i < P.size(); ++i)
+        EXPECT_EQ(Q[i].y, D[i].y);
+
+    // Decoded on the fly in expressions, and encoded from them
+    vector3DArray<double> S = Q + 2.0 * V;
+    EXPECT_DOUBLE_EQ(Q[5].x + 1, S[5].x);
+    Q = Q + V;
+    EXPECT_NEAR(P[9].z + 1, Q[9].z, Q.step().z);
+    EXPECT_THROW(Q = vector3DArray<double>(3), std::length_error);
+    EXPECT_THROW(Q.encode(vector3DArray<double>(3)), std::length_error);
+
+    quantized16_3DArray<float> F(777, vector3D<float>(-20, -20, -20), vector3D<float>(20, 20, 20));
+    vector3DArray<float> Pf(777);
+    for (std::size_t i = 0; i < 777; ++i)
+        Pf[i] = vector3D<float>(P[i].x, P[i].y, P[i].z);
+    F.encode(Pf);
+    vector3DArray<float> Df;
+    F.decode(Df);
+    EXPECT_NEAR(Pf[100].x, Df[100].x, F.max_error().x * 1.01);
+}
+
+int main(int argc, char **argv)
+{
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
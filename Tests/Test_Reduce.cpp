@@ -0,0 +1,233 @@
+/*
+ * This file is part of the Vector3D distribution (https://github.com/cdelv/Vector3D).
+ * Copyright (c) 2022 Carlos Andres del Valle.
+ *
+ *Vector3D is under the terms of the BSD-3 license. We welcome feedback and contributions.
+ *
+ * You should have received a copy of the BSD3 Public License
+ * along with this program. If not, see <https://github.com/cdelv/Vector3D> LICENSE.
+ *
+ *
+ * This library requires C++20.
+ */
+#include "../vector_reduce.h"
+#include <gtest/gtest.h>
+#include <cmath>
+#include <random>
+
+// Small integers, so that every sum is exact whatever the order
+static std::vector<vector3D<double>> integers(const std::size_t n) {
+    std::vector<vector3D<double>> v(n);
+    for (std::size_t i = 0; i < n; ++i)
+        v[i].load(double(i % 7) - 3, double(i % 11), -double(i % 13));
+    return v;
+}
+// Every split: one thread, more threads than ranges, ragged ranges
+static std::vector<reduce_options> splits() {
+    std::vector<reduce_options> s;
+    for (const std::size_t threads : {1, 2, 3, 8})
+        for (const std::size_t grain : {1, 5, 1000, 1 << 15}) {
+            reduce_options o;
+            o.threads = threads;
+            o.grain = grain;
+            s.push_back(o);
+        }
+    return s;
+}
+
+TEST(Reduce, sums) {
+    for (const std::size_t n : {0, 1, 3, 4, 5, 1001, 100003}) {
+        const std::vector<vector3D<double>> v = integers(n);
+        std::vector<double> w(n);
+        vector3D<double> sum(0, 0, 0), weighted(0, 0, 0);
+        for (std::size_t i = 0; i < n; ++i) {
+            w[i] = double(i % 3);
+            sum += v[i];
+            weighted += w[i] * v[i];
+        }
+        for (const reduce_options &o : splits()) {
+            const vector3D<double> s = parallel_sum(v, o);
+            EXPECT_EQ(sum.x, s.x) << n << " " << o.threads << " " << o.grain;
+            EXPECT_EQ(sum.y, s.y);
+            EXPECT_EQ(sum.z, s.z);
+            const vector3D<double> ws = parallel_weighted_sum(v, w, o);
+            EXPECT_EQ(weighted.x, ws.x);
+            EXPECT_EQ(weighted.z, ws.z);
+        }
+        if (n > 0) {
+            const vector3D<double> m = parallel_mean(v);
+            EXPECT_DOUBLE_EQ(sum.y / n, m.y);
+        }
+    }
+
+    // Other dimensions and component types
+    std::vector<vector2D<float>> u(1000, vector2D<float>(0.5f, -2));
+    const vector2D<float> su = parallel_sum(u, reduce_options{4, 10});
+    EXPECT_EQ(500, su.x);
+    EXPECT_EQ(-2000, su.y);
+    std::vector<vectorND<int, 5>> k(777);
+    for (std::size_t i = 0; i < k.size(); ++i)
+        k[i] = vectorND<int, 5>{1, int(i), -1, 2, int(i % 2)};
+    const vectorND<int, 5> sk = parallel_sum(k.data(), k.size(), reduce_options{3, 1});
+    EXPECT_EQ(777, sk[0]);
+    EXPECT_EQ(777 * 776 / 2, sk[1]);
+    EXPECT_EQ(388, sk[4]);
+
+    // Center of mass
+    std::vector<vector3D<double>> p = {{0, 0, 0}, {4, 0, 0}, {0, 8, 0}};
+    std::vector<double> mass = {2, 1, 1};
+    const vector3D<double> c = parallel_weighted_mean(p, mass);
+    EXPECT_EQ(1, c.x);
+    EXPECT_EQ(2, c.y);
+
+    EXPECT_THROW(parallel_mean(std::vector<vector3D<double>>()), std::length_error);
+    EXPECT_THROW(parallel_weighted_sum(p, std::vector<double>(2)), std::length_error);
+    EXPECT_THROW(parallel_weighted_mean(p, std::vector<double>(3)), std::domain_error);
+}
+TEST(Reduce, extremes) {
+    std::default_random_engine re(3);
+    std::uniform_real_distribution<double> rand(-10.0, 10.0);
+    for (const std::size_t n : {1, 2, 7, 50001}) {
+        std::vector<vector3D<double>> v(n);
+        for (vector3D<double> &x : v)
+            x.load(rand(re), rand(re), rand(re));
+        vector3D<double> lo = v[0], hi = v[0];
+        double norm = 0;
+        for (const vector3D<double> &x : v) {
+            for (std::size_t k = 0; k < 3; ++k) {
+                lo[k] = std::min(lo[k], x[k]);
+                hi[k] = std::max(hi[k], x[k]);
+            }
+            norm = std::max(norm, x.norm());
+        }
+        for (const reduce_options &o : splits()) {
+            const auto [a, b] = parallel_bounds(v, o);
+            EXPECT_EQ(lo.x, a.x) << n << " " << o.threads << " " << o.grain;
+            EXPECT_EQ(lo.z, a.z);
+            EXPECT_EQ(hi.y, b.y);
+            EXPECT_EQ(hi.z, b.z);
+            EXPECT_DOUBLE_EQ(norm, parallel_max_norm(v, o));
+        }
+        EXPECT_EQ(lo.y, parallel_min(v).y);
+        EXPECT_EQ(hi.x, parallel_max(v).x);
+    }
+    std::vector<vectorND<int, 4>> k = {{1, -5, 3, 0}, {-2, 7, 3, 9}};
+    EXPECT_EQ(-2, parallel_min(k)[0]);
+    EXPECT_EQ(9, parallel_max(k)[3]);
+    EXPECT_EQ(0, parallel_max_norm(std::vector<vector2D<double>>()));
+    EXPECT_THROW(parallel_bounds(std::vector<vector3D<double>>()), std::length_error);
+
+    // NaNs are skipped wherever they are, and a component with nothing else has NaN bounds
+    for (const std::size_t at : {0, 1, 2}) {
+        std::vector<vector3D<double>> w = {{3, 1, NAN}, {3, 4, NAN}, {-1, -2, NAN}};
+        w[at].x = NAN;
+        for (const reduce_options &o : splits()) {
+            const auto [a, b] = parallel_bounds(w, o);
+            EXPECT_EQ(at == 2 ? 3 : -1, a.x) << at << " " << o.threads << " " << o.grain;
+            EXPECT_EQ(3, b.x);
+            EXPECT_EQ(-2, a.y);
+            EXPECT_EQ(4, b.y);
+            EXPECT_TRUE(std::isnan(a.z) && std::isnan(b.z));
+        }
+    }
+    std::vector<vector2D<float>> f(1001, vector2D<float>(NAN, 1));
+    f[500].x = -7;
+    EXPECT_EQ(-7, parallel_min(f).x);
+    EXPECT_EQ(-7, parallel_max(f, reduce_options{3, 10}).x);
+}
+TEST(Reduce, covariance) {
+    // x and y perfectly correlated, z = -x
+    std::vector<vector3D<double>> v;
+    for (int i = 0; i < 100; ++i)
+        v.emplace_back(i, 2 * i + 1, -i);
+    const double var = 100 * 101 / 12.0;    // variance of 0, ..., 99 over n - 1
+    for (const reduce_options &o : splits()) {
+        const auto c = parallel_covariance(v, o);
+        EXPECT_NEAR(var, c[0][0], 1e-9);
+        EXPECT_NEAR(4 * var, c[1][1], 1e-9);
+        EXPECT_NEAR(2 * var, c[0][1], 1e-9);
+        EXPECT_EQ(c[0][1], c[1][0]);
+        EXPECT_NEAR(-var, c[2][0], 1e-9);
+    }
+    std::vector<vector2D<float>> u = {{1, 0}, {-1, 0}, {0, 2}, {0, -2}};
+    const auto c = parallel_covariance(u);
+    EXPECT_FLOAT_EQ(2 / 3.0f, c[0][0]);
+    EXPECT_FLOAT_EQ(8 / 3.0f, c[1][1]);
+    EXPECT_FLOAT_EQ(0, c[0][1]);
+    EXPECT_THROW(parallel_covariance(std::vector<vector3D<double>>(1)), std::length_error);
+}
+TEST(Reduce, deterministic) {
+    // Magnitudes far apart, so that every grouping of the additions rounds differently
+    std::default_random_engine re(7);
+    std::uniform_real_distribution<double> rand(-1.0, 1.0);
+    const std::size_t n = 300007;
+    std::vector<vector3D<double>> v(n);
+    std::vector<double> w(n);
+    for (std::size_t i = 0; i < n; ++i) {
+        const double scale = std::pow(10.0, double(i % 17) - 8);
+        v[i].load(scale * rand(re), rand(re), scale * scale * rand(re));
+        w[i] = 1 + rand(re);
+    }
+    reduce_options d;
+    d.deterministic = true;
+    const vector3D<double> s = parallel_sum(v, d);
+    const vector3D<double> ws = parallel_weighted_sum(v, w, d);
+    const vector3D<double> c = parallel_weighted_mean(v, w, d);
+    const auto C = parallel_covariance(v, d);
+    EXPECT_NEAR(s.x, parallel_sum(v).x, 1e-12 * std::abs(s.x));
+    thread_pool one(1), three(3), eight(8);
+    for (thread_pool* pool : {&one, &three, &eight})
+        for (const std::size_t threads : {0, 1, 2, 5})
+            for (const std::size_t grain : {1, 1000, 5000, 1 << 20}) {
+                reduce_options o = d;
+                o.pool = pool;
+                o.threads = threads;
+                o.grain = grain;
+                const vector3D<double> t = parallel_sum(v, o);
+                EXPECT_EQ(s.x, t.x) << pool->size() << " " << threads << " " << grain;
+                EXPECT_EQ(s.y, t.y);
+                EXPECT_EQ(s.z, t.z);
+                EXPECT_EQ(ws.z, parallel_weighted_sum(v, w, o).z);
+                EXPECT_EQ(c.x, parallel_weighted_mean(v, w, o).x);
+                EXPECT_EQ(C[0][2], parallel_covariance(v, o)[0][2]);
+            }
+}
+TEST(Reduce, policies) {
+    // A million times float(0.1): the float sum drifts, the others stay close to the exact sum
+    const std::size_t n = 1000000;
+    std::vector<vector3D<float>> v(n, vector3D<float>(0.1f, 1, -0.3f));
+    const double x = double(0.1f) * n, z = double(-0.3f) * n;
+    for (const reduce_options &o : {reduce_options{1, 1 << 15}, reduce_options{3, 1000}}) {
+        const vector3D<double> w = parallel_sum(v, widened_sum(), o);
+        EXPECT_NEAR(x, w.x, 1e-9 * x);
+        EXPECT_NEAR(z, w.z, 1e-9 * -z);
+        EXPECT_EQ(n, w.y);
+        EXPECT_GT(std::abs(parallel_sum(v, naive_sum(), o).x - x), 1e-5 * x);
+        EXPECT_NEAR(x, parallel_sum(v, kahan_sum(), o).x, 1e-7 * x);
+        EXPECT_NEAR(x, parallel_sum(v, pairwise_sum(), o).x, 1e-6 * x);
+        EXPECT_NEAR(double(0.1f), parallel_mean(v, widened_sum(), o).x, 1e-12);
+    }
+    static_assert(std::is_same_v<decltype(parallel_sum(v, widened_sum())), vector3D<double>>);
+    static_assert(std::is_same_v<decltype(parallel_sum(v, kahan_sum())), vector3D<float>>);
+
+    // Weights, other dimensions, and the deterministic mode
+    std::vector<float> w(n, 0.5f);
+    EXPECT_NEAR(x / 2, parallel_weighted_sum(v, w, kahan_sum()).x, 1e-7 * x);
+    EXPECT_NEAR(double(-0.3f), parallel_weighted_mean(v, w, widened_sum()).z, 1e-12);
+    std::vector<vectorND<float, 9>> u(n / 10, vectorND<float, 9>(0.1f));
+    EXPECT_NEAR(x / 10, parallel_sum(u, kahan_sum())[8], 1e-7 * x);
+    reduce_options d;
+    d.deterministic = true;
+    thread_pool four(4);
+    reduce_options d4 = d;
+    d4.pool = &four;
+    d4.grain = 1;
+    EXPECT_EQ(parallel_sum(v, kahan_sum(), d).z, parallel_sum(v, kahan_sum(), d4).z);
+    EXPECT_EQ(parallel_sum(v, pairwise_sum(), d).x, parallel_sum(v, pairwise_sum(), d4).x);
+}
+
+int main(int argc, char **argv)
+{
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
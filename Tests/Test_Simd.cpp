@@ -0,0 +1,288 @@
+/*
+ * This file is part of the Vector3D distribution (https://github.com/cdelv/Vector3D).
+ * Copyright (c) 2022 Carlos Andres del Valle.
+ *
+ *Vector3D is under the terms of the BSD-3 license. We welcome feedback and contributions.
+ *
+ * You should have received a copy of the BSD3 Public License
+ * along with this program. If not, see <https://github.com/cdelv/Vector3D> LICENSE.
+ *
+ *
+ * This library requires C++20.
+ */
+#include "../vector_simd.h"
+#include <gtest/gtest.h>
+#include <random>
+#include <limits>
+
+// Sizes that leave a remainder for every register width
+const std::size_t N = 75;
+
+template <typename T>
+std::vector<vector3D<T>> random3D(const std::size_t n, const unsigned seed) {
+    std::default_random_engine re(seed);
+    std::uniform_real_distribution<T> rand(-10, 10);
+    std::vector<vector3D<T>> v(n);
+    for (auto& x : v)
+        x.load(rand(re), rand(re), rand(re));
+    return v;
+}
+template <typename T>
+std::vector<vector2D<T>> random2D(const std::size_t n, const unsigned seed) {
+    std::default_random_engine re(seed);
+    std::uniform_real_distribution<T> rand(-10, 10);
+    std::vector<vector2D<T>> v(n);
+    for (auto& x : v)
+        x.load(rand(re), rand(re));
+    return v;
+}
+// Within a few ulp of scale, the size of the terms: fused multiply-adds round differently, and the
+// difference is relative to the products that cancel, not to the result.
+template <typename T>
+void expect_close(const T expected, const T result, const T scale) {
+    EXPECT_NEAR(expected, result, 4 * std::numeric_limits<T>::epsilon() * scale);
+}
+// Results without cancellation
+template <typename T>
+void expect_close(const T expected, const T result) {
+    expect_close(expected, result, std::abs(expected));
+}
+// Sizes of the terms of u * v and of the components of u ^ v
+template <typename V>
+auto terms(const V &u, const V &v) {
+    auto t = std::abs(u[0] * v[0]);
+    for (std::size_t c = 1; c < V::size(); ++c)
+        t += std::abs(u[c] * v[c]);
+    return t;
+}
+template <typename T>
+vector3D<T> cross_terms(const vector3D<T> &u, const vector3D<T> &v) {
+    return vector3D<T>(std::abs(u.y * v.z) + std::abs(u.z * v.y), std::abs(u.z * v.x) + std::abs(u.x * v.z), std::abs(u.x * v.y) + std::abs(u.y * v.x));
+}
+template <typename T>
+T cross_terms(const vector2D<T> &u, const vector2D<T> &v) {
+    return std::abs(u.x * v.y) + std::abs(u.y * v.x);
+}
+// The angle through its cosine, which has the error of the dot product: acos adds an error of its own
+template <typename T>
+void expect_close_angle(const T expected, const T result) {
+    EXPECT_NEAR(std::cos(expected), std::cos(result), 8 * std::numeric_limits<T>::epsilon());
+}
+
+template <typename T>
+class Batch : public ::testing::Test {};
+using Types = ::testing::Types<float, double>;
+TYPED_TEST_SUITE(Batch, Types);
+
+// Run a test body once with every instruction set this CPU supports
+template <typename F>
+void for_each_isa(const F& body) {
+    const simd_isa initial = batch_isa();
+    for (const simd_isa isa : {simd_isa::scalar, simd_isa::sse42, simd_isa::avx2, simd_isa::avx512}) {
+        if (!set_batch_isa(isa))
+            continue;
+        SCOPED_TRACE(simd_isa_name(isa));
+        body();
+    }
+    set_batch_isa(initial);
+}
+//Dispatch
+TEST(Dispatch, isa_selection) {
+    EXPECT_TRUE(simd_isa_supported(simd_isa::scalar));
+    EXPECT_TRUE(simd_isa_supported(batch_isa()));
+    EXPECT_TRUE(set_batch_isa(simd_isa::scalar));
+    EXPECT_EQ(simd_isa::scalar, batch_isa());
+    if (!simd_isa_supported(simd_isa::avx512)) {
+        EXPECT_FALSE(set_batch_isa(simd_isa::avx512));
+        EXPECT_EQ(simd_isa::scalar, batch_isa());
+    }
+    EXPECT_STREQ("avx2", simd_isa_name(simd_isa::avx2));
+    set_batch_isa(__detect_isa());
+}
+
+//Dot, norm and angle of arrays of structs
+TYPED_TEST(Batch, scalar_results_3D) {
+    using T = TypeParam;
+    for_each_isa([] {
+        auto u = random3D<T>(N, 1), v = random3D<T>(N, 2);
+        std::vector<T> out(N);
+
+        batch_dot(u.data(), v.data(), out.data(), N);
+        for (std::size_t i = 0; i < N; ++i)
+            expect_close(dot(u[i], v[i]), out[i], terms(u[i], v[i]));
+
+        batch_norm2(u.data(), out.data(), N);
+        for (std::size_t i = 0; i < N; ++i)
+            expect_close(norm2(u[i]), out[i]);
+
+        batch_norm(u.data(), out.data(), N);
+        for (std::size_t i = 0; i < N; ++i)
+            expect_close(norm(u[i]), out[i]);
+
+        batch_angle(u.data(), v.data(), out.data(), N);
+        for (std::size_t i = 0; i < N; ++i)
+            expect_close_angle(angle(u[i], v[i]), out[i]);
+    });
+}
+TYPED_TEST(Batch, scalar_results_2D) {
+    using T = TypeParam;
+    for_each_isa([] {
+        auto u = random2D<T>(N, 3), v = random2D<T>(N, 4);
+        std::vector<T> out(N);
+
+        batch_dot(u.data(), v.data(), out.data(), N);
+        for (std::size_t i = 0; i < N; ++i)
+            expect_close(dot(u[i], v[i]), out[i], terms(u[i], v[i]));
+
+        batch_norm(u.data(), out.data(), N);
+        for (std::size_t i = 0; i < N; ++i)
+            expect_close(norm(u[i]), out[i]);
+
+        batch_cross(u.data(), v.data(), out.data(), N);
+        for (std::size_t i = 0; i < N; ++i)
+            expect_close(cross(u[i], v[i]), out[i], cross_terms(u[i], v[i]));
+    });
+}
+//Small integers: every result is exact, whatever the rounding, so a misplaced component shows up
+TYPED_TEST(Batch, exact_layout) {
+    using T = TypeParam;
+    for_each_isa([] {
+        std::vector<vector3D<T>> u(N), v(N), w(N);
+        std::vector<vector2D<T>> p(N), q(N);
+        for (std::size_t i = 0; i < N; ++i) {
+            u[i].load(T(i % 7), -T(i % 5), T(i % 11) - 5);
+            v[i].load(T(i % 3) - 1, T(i % 13), T(2));
+            p[i].load(T(i % 9), T(1) - T(i % 4));
+            q[i].load(-T(i % 6), T(i % 8));
+        }
+        std::vector<T> out(N);
+        batch_dot(u.data(), v.data(), out.data(), N);
+        for (std::size_t i = 0; i < N; ++i)
+            EXPECT_EQ(dot(u[i], v[i]), out[i]) << i;
+        batch_norm2(p.data(), out.data(), N);
+        for (std::size_t i = 0; i < N; ++i)
+            EXPECT_EQ(norm2(p[i]), out[i]) << i;
+        batch_cross(p.data(), q.data(), out.data(), N);
+        for (std::size_t i = 0; i < N; ++i)
+            EXPECT_EQ(cross(p[i], q[i]), out[i]) << i;
+        batch_cross(u.data(), v.data(), w.data(), N);
+        for (std::size_t i = 0; i < N; ++i) {
+            const vector3D<T> expected = u[i] ^ v[i];
+            EXPECT_EQ(expected.x, w[i].x) << i;
+            EXPECT_EQ(expected.y, w[i].y) << i;
+            EXPECT_EQ(expected.z, w[i].z) << i;
+        }
+        // Unit vectors of (3, 4) and (2, 3, 6) are exact too
+        std::vector<vector2D<T>> a(N, vector2D<T>(3, -4));
+        std::vector<vector3D<T>> b(N, vector3D<T>(2, -3, 6));
+        for (std::size_t i = 0; i < N; i += 2) {
+            a[i] = -a[i];
+            b[i] = T(i) * b[i];
+        }
+        b[0].load(0, 0, 7);
+        batch_unit(a.data(), a.data(), N);
+        batch_unit(b.data(), b.data(), N);
+        for (std::size_t i = 0; i < N; ++i) {
+            EXPECT_EQ(i % 2 ? T(3) / 5 : T(-3) / 5, a[i].x) << i;
+            EXPECT_EQ(i % 2 ? T(-4) / 5 : T(4) / 5, a[i].y) << i;
+            EXPECT_EQ(i > 0 ? T(2) / 7 : T(0), b[i].x) << i;
+            EXPECT_EQ(i > 0 ? T(-3) / 7 : T(0), b[i].y) << i;
+            EXPECT_EQ(i > 0 ? T(6) / 7 : T(1), b[i].z) << i;
+        }
+    });
+}
+//Vector results
+TYPED_TEST(Batch, vector_results) {
+    using T = TypeParam;
+    for_each_isa([] {
+        auto u = random3D<T>(N, 5), v = random3D<T>(N, 6);
+        std::vector<vector3D<T>> out(N);
+
+        batch_cross(u.data(), v.data(), out.data(), N);
+        for (std::size_t i = 0; i < N; ++i) {
+            vector3D<T> expected = u[i] ^ v[i], scale = cross_terms(u[i], v[i]);
+            for (std::size_t c = 0; c < 3; ++c)
+                expect_close(expected[c], out[i][c], scale[c]);
+        }
+
+        // In place
+        auto w = u;
+        batch_unit(w.data(), w.data(), N);
+        for (std::size_t i = 0; i < N; ++i) {
+            vector3D<T> expected = unit(u[i]);
+            for (std::size_t c = 0; c < 3; ++c)
+                expect_close(expected[c], w[i][c], T(1));
+        }
+
+        w = v;
+        batch_axpy(T(0.5), u.data(), w.data(), N);
+        for (std::size_t i = 0; i < N; ++i) {
+            vector3D<T> expected = v[i] + T(0.5) * u[i];
+            for (std::size_t c = 0; c < 3; ++c)
+                expect_close(expected[c], w[i][c], std::abs(v[i][c]) + std::abs(u[i][c]));
+        }
+
+        auto p = random2D<T>(N, 7), q = random2D<T>(N, 8);
+        batch_unit(p.data(), q.data(), N);
+        for (std::size_t i = 0; i < N; ++i) {
+            vector2D<T> expected = unit(p[i]);
+            expect_close(expected.x, q[i].x, T(1));
+            expect_close(expected.y, q[i].y, T(1));
+        }
+    });
+}
+//Structure of arrays
+TYPED_TEST(Batch, structure_of_arrays) {
+    using T = TypeParam;
+    for_each_isa([] {
+        auto u = random3D<T>(N, 9), v = random3D<T>(N, 10);
+        vector3DArray<T> U(u), V(v), W(N);
+        std::vector<T> out(N);
+
+        batch_dot(U, V, out.data());
+        for (std::size_t i = 0; i < N; ++i)
+            expect_close(dot(u[i], v[i]), out[i], terms(u[i], v[i]));
+
+        batch_cross(U, V, W);
+        for (std::size_t i = 0; i < N; ++i)
+            expect_close((u[i] ^ v[i]).operator[](1), W[i].y, cross_terms(u[i], v[i]).y);
+
+        batch_unit(U, W);
+        for (std::size_t i = 0; i < N; ++i)
+            expect_close(unit(u[i])[2], W[i].z, T(1));
+
+        W = V;
+        batch_axpy(T(2), U, W);
+        for (std::size_t i = 0; i < N; ++i)
+            expect_close(v[i].z + 2 * u[i].z, W[i].z, std::abs(v[i].z) + 2 * std::abs(u[i].z));
+    });
+}
+TYPED_TEST(Batch, structure_of_arrays_sizes) {
+    using T = TypeParam;
+    auto u = random3D<T>(N, 11);
+    vector3DArray<T> U(u), S(N - 1);
+    std::vector<T> out(N);
+    // Operands of different sizes
+    EXPECT_THROW(batch_dot(U, S, out.data()), std::length_error);
+    EXPECT_THROW(batch_angle(S, U, out.data()), std::length_error);
+    vector3DArray<T> W(N);
+    EXPECT_THROW(batch_cross(U, S, W), std::length_error);
+    EXPECT_THROW(batch_axpy(T(2), U, S), std::length_error);
+    EXPECT_THROW(batch_axpy(T(2), S, U), std::length_error);
+    EXPECT_EQ(N - 1, S.size());
+    // The output array is resized
+    auto v = random3D<T>(N, 12);
+    vector3DArray<T> V(v), R(3);
+    batch_cross(U, V, R);
+    ASSERT_EQ(N, R.size());
+    expect_close((u[N - 1] ^ v[N - 1])[0], R[N - 1].x, cross_terms(u[N - 1], v[N - 1]).x);
+    batch_unit(U, S);
+    ASSERT_EQ(N, S.size());
+    expect_close(unit(u[N - 1])[0], S[N - 1].x, T(1));
+}
+
+int main(int argc, char **argv)
+{
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,292 @@
+/*
+ * This file is part of the Vector3D distribution (https://github.com/cdelv/Vector3D).
+ * Copyright (c) 2022 Carlos Andres del Valle.
+ *
+ *Vector3D is under the terms of the BSD-3 license. We welcome feedback and contributions.
+ *
+ * You should have received a copy of the BSD3 Public License
+ * along with this program. If not, see <https://github.com/cdelv/Vector3D> LICENSE.
+ *
+ *
+ * This library requires C++20.
+ */
+#include "../vector_text.h"
+#include <gtest/gtest.h>
+#include <cmath>
+#include <filesystem>
+#include <sstream>
+
+static std::string temp_file(const std::string &name) {
+    return (std::filesystem::temp_directory_path() / ("vector3d_test_" + name)).string();
+}
+// n lines of x y z, every tenth one with commas
+static std::string numbers(const std::size_t n) {
+    std::ostringstream s;
+    s.precision(17);
+    for (std::size_t i = 0; i < n; ++i) {
+        if (i % 10 == 0)
+            s << 0.5 * i << ", " << -1.25 * i << "," << 1e-3 * i << "\r\n";
+        else
+            s << 0.5 * i << " " << -1.25 * i << "\t" << 1e-3 * i << "\n";
+    }
+    return s.str();
+}
+// A vector whose copies throw while fail is set
+struct fragile : public vector3D<double> {
+    static inline bool fail = false;
+    fragile(const vector3D<double> &v) : vector3D<double>(v) {}
+    fragile(const fragile &other) : vector3D<double>(other) {
+        if (fail) throw std::runtime_error("fragile: copy");
+    }
+    fragile& operator=(const fragile &other) {
+        if (fail) throw std::runtime_error("fragile: copy");
+        vector3D<double>::operator=(other);
+        return *this;
+    }
+};
+static bool same(const std::vector<vector3D<double>> &a, const std::vector<vector3D<double>> &b) {
+    return std::equal(a.begin(), a.end(), b.begin(), b.end(), [](const auto &u, const auto &v) {
+        return u.x == v.x && u.y == v.y && u.z == v.z;
+    });
+}
+
+TEST(Text, formats) {
+    std::vector<vector3D<double>> v = parse_vectors<vector3D<double>>("1 2 3\n  -4.5\t+5e2 6\n\n# comment\n7,8, 9\r\n1e-3,-0 , 2");
+    ASSERT_EQ(4, v.size());
+    EXPECT_EQ(-4.5, v[1].x);
+    EXPECT_EQ(500, v[1].y);
+    EXPECT_EQ(9, v[2].z);
+    EXPECT_EQ(1e-3, v[3].x);
+    EXPECT_EQ(2, v[3].z);
+
+    // XYZ: atom count, comment, and the element in front
+    text_options xyz;
+    xyz.header_lines = 2;
+    xyz.skip_columns = 1;
+    std::vector<vector3D<float>> a = parse_vectors<vector3D<float>>("2\nwater 1 2 3\nO 0.0 0.0 0.1\nH 0.0 0.75 -0.5\n", xyz);
+    ASSERT_EQ(2, a.size());
+    EXPECT_FLOAT_EQ(0.75f, a[1].y);
+
+    // CSV with a header, and other dimensions
+    text_options csv;
+    csv.header_lines = 1;
+    std::vector<vector2D<double>> b = parse_vectors<vector2D<double>>("x,y\n1,2\n3,4\n", csv);
+    ASSERT_EQ(2, b.size());
+    EXPECT_EQ(4, b[1].y);
+    std::vector<vectorND<int, 4>> c = parse_vectors<vectorND<int, 4>>("1 2 3 4\n-5 6 7 8");
+    EXPECT_EQ(-5, c[1][0]);
+}
+TEST(Text, errors) {
+    const std::string text = "1 2 3\n4 5\n6 x 8\n1 2 3 4\n9 9 9\n1.5e999 0 0\n1 2 3junk\n";
+    try {
+        parse_vectors<vector3D<double>>(text);
+        FAIL() << "no exception";
+    }
+    catch (const vector_parse_error &e) {
+        EXPECT_EQ(2, e.error.line);
+        EXPECT_EQ(4, e.error.column);
+        EXPECT_EQ("too few values", e.error.message);
+        EXPECT_EQ("4 5", e.error.text);
+        EXPECT_EQ(std::string("<text>:2:4: too few values: 4 5"), e.what());
+    }
+
+    std::vector<text_error> errors;
+    std::vector<vector3D<double>> v = parse_vectors<vector3D<double>>(text, text_options(), &errors);
+    ASSERT_EQ(2, v.size());
+    EXPECT_EQ(9, v[1].x);
+    ASSERT_EQ(5, errors.size());
+    EXPECT_EQ("too few values", errors[0].message);
+    EXPECT_EQ(3, errors[1].line);
+    EXPECT_EQ(3, errors[1].column);
+    EXPECT_EQ("expected a number", errors[1].message);
+    EXPECT_EQ("too many values", errors[2].message);
+    EXPECT_EQ(7, errors[2].column);
+    EXPECT_EQ("number out of range", errors[3].message);
+    EXPECT_EQ(6, errors[3].line);
+    EXPECT_EQ(7, errors[4].line);
+    EXPECT_EQ(6, errors[4].column);
+    EXPECT_EQ("unexpected character", errors[4].message);
+}
+TEST(Text, chunks_and_threads) {
+    const std::string path = temp_file("vectors.xyz");
+    const std::size_t n = 100000;
+    const std::string text = "# generated\n" + numbers(n / 2) + "1 2 oops\n" + numbers(n / 2);
+    std::ofstream(path, std::ios::binary) << text;
+
+    std::vector<text_error> errors;
+    const std::vector<vector3D<double>> serial = parse_vectors<vector3D<double>>(text, text_options(), &errors);
+    ASSERT_EQ(n, serial.size());
+    ASSERT_EQ(1, errors.size());
+    EXPECT_EQ(n / 2 + 2, errors[0].line);
+    EXPECT_EQ(0.5 * 123, serial[123].x);
+    EXPECT_EQ(-1.25 * 5, serial[n / 2 + 5].y);
+
+    // Tiny chunks split lines and numbers, many threads split every chunk
+    for (const std::size_t chunk : {std::size_t(7), std::size_t(4096), std::size_t(1 << 20), std::size_t(16 << 20)})
+        for (const std::size_t threads : {1, 3, 8}) {
+            text_options options;
+            options.chunk_bytes = chunk;
+            options.threads = threads;
+            errors.clear();
+            EXPECT_TRUE(same(serial, read_vectors<vector3D<double>>(path, options, &errors))) << chunk << " " << threads;
+            ASSERT_EQ(1, errors.size());
+            EXPECT_EQ(n / 2 + 2, errors[0].line);
+            EXPECT_EQ(5, errors[0].column);
+            try {
+                read_vectors<vector3D<double>>(path, options);
+                FAIL() << "no exception";
+            }
+            catch (const vector_parse_error &e) {
+                EXPECT_EQ(n / 2 + 2, e.error.line);
+            }
+        }
+    std::filesystem::remove(path);
+    EXPECT_THROW(read_vectors<vector3D<double>>(path), std::runtime_error);
+}
+TEST(Text, format) {
+    std::vector<vector3D<double>> v = {{1, -2.5, 3e-20}, {0.1, 1e300, -0.0}};
+    EXPECT_EQ("1 -2.5 3e-20\n0.1 1e+300 -0\n", format_vectors(v));
+    format_options o;
+    o.format = text_format::csv;
+    EXPECT_EQ("x,y,z\n1,-2.5,3e-20\n0.1,1e+300,-0\n", format_vectors(v, o));
+    o.header = false;
+    o.separator = ";";
+    EXPECT_EQ("1;-2.5;3e-20\n0.1;1e+300;-0\n", format_vectors(v, o));
+    o.format = text_format::xyz;
+    o.separator.clear();
+    o.element = "Ar";
+    o.comment = "t = 0";
+    EXPECT_EQ("2\nt = 0\nAr 1 -2.5 3e-20\nAr 0.1 1e+300 -0\n", format_vectors(v, o));
+
+    // The same text as operator<<
+    std::vector<vector2D<float>> u = {{1.5f, -2}};
+    std::ostringstream s;
+    s << u[0] << "\n";
+    o = format_options();
+    o.format = text_format::tuple;
+    EXPECT_EQ(s.str(), format_vectors(u, o));
+    std::vector<vectorND<int, 4>> w = {{1, -2, 3, 4}};
+    o.format = text_format::csv;
+    EXPECT_EQ("c0,c1,c2,c3\n1,-2,3,4\n", format_vectors(w, o));
+
+    o = format_options();
+    o.precision = 3;
+    EXPECT_EQ("3.14 1e+06\n", format_vectors(std::vector<vector2D<double>>{{M_PI, 1e6}}, o));
+}
+TEST(Text, write) {
+    const std::string path = temp_file("written.txt");
+    std::vector<vector3D<double>> v(30000);
+    for (std::size_t i = 0; i < v.size(); ++i)
+        v[i].load(std::sqrt(i), -1.0 / (i + 1), i * 1e100);
+
+    // Every format reads back exactly, with a buffer much smaller than the output
+    for (const text_format f : {text_format::plain, text_format::csv, text_format::tuple, text_format::xyz}) {
+        format_options o;
+        o.format = f;
+        o.buffer_bytes = 5000;
+        {
+            vector_writer out(path, o);
+            out.write(v);
+        }
+        text_options in;
+        in.header_lines = f == text_format::xyz ? 2 : f == text_format::csv ? 1 : 0;
+        in.skip_columns = f == text_format::xyz;
+        EXPECT_TRUE(same(v, read_vectors<vector3D<double>>(path, in))) << static_cast<int>(f);
+    }
+
+    // Appends, and arrays of structures
+    vector3DArray<double> P(v);
+    {
+        vector_writer out(path);
+        out.write(P);
+        out.write(v.data(), 10);
+        out.close();
+        EXPECT_THROW(out.write(v), std::runtime_error);
+    }
+    {
+        vector_writer out(path, format_options(), true);
+        out.write(v);
+    }
+    std::vector<vector3D<double>> r = read_vectors<vector3D<double>>(path);
+    ASSERT_EQ(2 * v.size() + 10, r.size());
+    EXPECT_EQ(v[9].y, r[v.size() + 9].y);
+    EXPECT_EQ(v[123].z, r[v.size() + 10 + 123].z);
+    std::filesystem::remove(path);
+
+    // Appended CSV frames have the header only at the top of the file
+    format_options csv;
+    csv.format = text_format::csv;
+    for (int frame = 0; frame < 3; ++frame) {
+        vector_writer out(path, csv, true);
+        out.write(v.data() + frame, 10);
+    }
+    text_options in;
+    in.header_lines = 1;
+    r = read_vectors<vector3D<double>>(path, in);
+    ASSERT_EQ(30, r.size());
+    EXPECT_EQ(v[2 + 9].x, r[29].x);
+    std::filesystem::remove(path);
+    EXPECT_THROW(vector_writer(temp_file("missing/file.txt")), std::runtime_error);
+}
+TEST(Text, async_write) {
+    const std::string path = temp_file("trajectory.txt");
+    std::vector<vector3D<double>> v(1000);
+    vector3DArray<double> P(v.size());
+    {
+        async_vector_writer<vector3D<double>> out(path, format_options(), 1);
+        for (int frame = 0; frame < 20; ++frame) {
+            for (std::size_t i = 0; i < v.size(); ++i) {
+                v[i].load(frame, i, -0.5 * i);
+                P[i].load(frame, i, 0.25 * i);
+            }
+            // The frame is copied: changing v afterwards doesn't change what is written
+            out.write(v);
+            out.write(P);
+            std::vector<vector3D<double>> moved(v);
+            out.write(std::move(moved));
+        }
+        out.flush();
+        const writer_stats s = out.stats();
+        EXPECT_EQ(60, s.frames);
+        EXPECT_LE(s.max_stall, s.stall_time);
+        EXPECT_GT(s.write_time.count(), 0);
+        out.close();
+        EXPECT_THROW(out.write(v), std::runtime_error);
+    }
+    std::vector<vector3D<double>> r = read_vectors<vector3D<double>>(path);
+    ASSERT_EQ(60 * v.size(), r.size());
+    for (std::size_t frame = 0; frame < 60; ++frame) {
+        EXPECT_EQ(frame / 3, r[frame * v.size() + 7].x);
+        EXPECT_EQ(frame % 3 == 1 ? 0.25 * 999 : -0.5 * 999, r[frame * v.size() + 999].z);
+    }
+    std::filesystem::remove(path);
+
+    // A frame that can't be copied gives its slot back
+    {
+        std::vector<fragile> f(v.begin(), v.end());
+        async_vector_writer<fragile> out(path, format_options(), 1);
+        fragile::fail = true;
+        EXPECT_THROW(out.write(f), std::runtime_error);
+        fragile::fail = false;
+        out.write(f);
+        out.flush();
+        EXPECT_EQ(1, out.stats().frames);
+    }
+    EXPECT_EQ(v.size(), read_vectors<vector3D<double>>(path).size());
+    std::filesystem::remove(path);
+
+    // Errors on the background thread come back to the caller
+    format_options small;
+    small.buffer_bytes = 4096;
+    async_vector_writer<vector3D<double>> full("/dev/full", small);
+    full.write(v);
+    EXPECT_THROW(full.flush(), std::runtime_error);
+    EXPECT_THROW(full.write(v), std::runtime_error);
+    EXPECT_THROW(full.close(), std::runtime_error);
+}
+
+int main(int argc, char **argv)
+{
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,36 @@
+/*
+ * This file is part of the Vector3D distribution (https://github.com/cdelv/Vector3D).
+ * Copyright (c) 2022 Carlos Andres del Valle.
+ *
+ * Vector3D is under the terms of the BSD-3 license. We welcome feedback and contributions.
+ *
+ * you should have received a copy of the BSD3 Public License
+ * along with this program. If not, see <https://github.com/cdelv/Vector3D> LICENSE.
+ *
+ *
+ * This library requires C++20.
+*/
+
+/*
+*  Module interface of vector.h: import vector3d; gives the same API as #include "vector.h".
+*  The standard headers go in the global module fragment, so that they stay shareable with the
+*  importers. vector.h is then included in the purview, where #pragma once skips nothing and its
+*  declarations become exported. Build it once, before its importers:
+*      g++ -std=c++20 -fmodules-ts -x c++ -c vector.cppm
+*  Don't include vector.h and import vector3d in the same translation unit. Macros such as
+*  VECTOR3D_FMA take effect when building the module, not in the importers.
+*/
+module;
+#include <iostream>
+#include <complex>
+#include <cmath>
+#include <vector>
+#include <array>
+#include <utility>
+#include <algorithm>
+#include <concepts>
+export module vector3d;
+
+export {
+#include "vector.h"
+}
@@ -3,7 +3,10 @@
 #include <complex>
 #include <cmath>
 #include <vector>
+#include <array>
+#include <utility>
 #include <algorithm>
+#include <concepts>
 
 /*
  * This file is part of the Vector3D distribution (https://github.com/cdelv/Vector3D).
@@ -27,9 +30,48 @@ struct is_complex : std::false_type {};
 template <typename T>
 struct is_complex<std::complex<T>> : std::is_arithmetic<T> {};
 template <typename T>
-static constexpr bool is_complex_v = is_complex<T>::value;
+inline constexpr bool is_complex_v = is_complex<T>::value;
+// 16 bit floating point types (vector_half.h). They are stored in 16 bits and computed in float.
 template <typename T>
-concept __Number = std::is_arithmetic_v<T> || is_complex_v<T>;
+struct is_half_float : std::false_type {};
+template <typename T>
+inline constexpr bool is_half_float_v = is_half_float<T>::value;
+template <typename T>
+concept __Number = std::is_arithmetic_v<T> || is_complex_v<T> || is_half_float_v<T>;
+/*
+*  Fused multiply-add
+*  Define VECTOR3D_FMA before including this file to evaluate a * u + v, u * a - v, ElemProd(u, v) + w and the
+*  products inside dot() with a single rounding. It only takes effect if the target has FMA instructions
+*  (-mfma, -march=native), otherwise std::fma is a slow library call. The results differ from the unfused ones
+*  in the last bit, that is why it is opt-in.
+*/
+#if defined(VECTOR3D_FMA) && (defined(__FMA__) || defined(FP_FAST_FMA))
+inline constexpr bool __use_fma = true;
+#else
+inline constexpr bool __use_fma = false;
+#endif
+// a * b + c, fused if enabled and the three have the same floating point type
+template <typename A, typename B, typename C>
+inline constexpr auto __vec_fma(const A &a, const B &b, const C &c) noexcept {
+    if constexpr (__use_fma && std::is_floating_point_v<A> && std::is_same_v<A, B> && std::is_same_v<A, C>) {
+        if (!std::is_constant_evaluated())
+            return std::fma(a, b, c);
+    }
+    return a * b + c;
+}
+// Product nodes expose the factors of each component, so that sums can fuse them
+template <typename E>
+inline constexpr bool __is_product_v = requires(const E &e) { e.template __factors<0>(); };
+// Sums expose their operands: (u + v) + v, with E2 repeated on both levels
+template <typename E1, typename E2>
+inline constexpr bool __is_repeated_sum_v = requires(const E1 &e) { { e.__right() } -> std::same_as<const E2&>; };
+// Nodes hold their operands by reference, so a repeated operand is the same object on both sides.
+// Compared at run time: the rewrite does not depend on what the optimizer manages to prove.
+template <typename E1, typename E2>
+inline constexpr bool __same_object(const E1 &u, const E2 &v) noexcept {
+    if constexpr (std::is_same_v<E1, E2>) return &u == &v;
+    else return false;
+}
 /*
 *  Expression template to avoid unnecessary allocations in chained operations
 */
@@ -39,10 +81,50 @@ public:
     inline constexpr const auto operator[](const std::size_t i) const {
         return static_cast<E const&>(*this)[i];
     }
+    // Compile time access. Deep expressions reduce to straight-line code without index checks.
+    template <std::size_t I>
+    inline constexpr const auto get() const noexcept {
+        static_assert(I < N, "Index out of range");
+        return static_cast<E const&>(*this).template get<I>();
+    }
     static inline constexpr const std::size_t size() {
         return N;
     }
 };
+// Compile time loop over the components: f(std::integral_constant<std::size_t, I>) for I = 0, ..., N - 1
+template <std::size_t N, typename F>
+inline constexpr void __static_for(F &&f) {
+    [&]<std::size_t... I>(std::index_sequence<I...>) {
+        (f(std::integral_constant<std::size_t, I>{}), ...);
+    }(std::make_index_sequence<N>{});
+}
+// Components up to which the loops of vectorND are unrolled at compile time
+inline constexpr std::size_t __unroll_limit = 16;
+/*
+*  Cost model. Nodes evaluate lazily per component, so a node that reads each component of an operand
+*  several times (cross, unit) would recompute a costly operand every time. Such operands are evaluated
+*  once into a vector when the node is built.
+*/
+template <__Number T> class vector3D;
+template <__Number T> class vector2D;
+template <__Number T, std::size_t N> class vectorND;
+// Vector class that an expression evaluates into
+template <typename E, std::size_t N = E::size()>
+using __eval_t = std::conditional_t<N == 3, vector3D<std::remove_cvref_t<decltype(std::declval<const E&>()[0])>>,
+                 std::conditional_t<N == 2, vector2D<std::remove_cvref_t<decltype(std::declval<const E&>()[0])>>,
+                                            vectorND<std::remove_cvref_t<decltype(std::declval<const E&>()[0])>, N>>>;
+// Arithmetic operations to evaluate one component of an expression. Vectors cost nothing.
+template <typename E>
+inline constexpr std::size_t __cost_v = [] {
+    if constexpr (requires { E::__cost; }) return E::__cost;
+    else return std::size_t(0);
+}();
+// Cost from which an operand read more than once is evaluated once. Once inlined, the evaluated
+// components stay in registers, so anything beyond a plain load is worth it.
+inline constexpr std::size_t __materialize_cost = 1;
+// How a node holds an operand whose components it reads Reads times: by reference, or evaluated
+template <typename E, std::size_t Reads>
+using __operand_t = std::conditional_t<(Reads > 1 && __cost_v<E> >= __materialize_cost), const __eval_t<E>, const E&>;
 // std::cout << operator
 template <typename E, std::size_t N>
 std::ostream& operator<<(std::ostream& os, const __VecExpression<E, N>& vec) {
@@ -57,25 +139,138 @@ std::ostream& operator<<(std::ostream& os, const __VecExpression<E, N>& vec) {
     return os;
 }
 /*
+*  Accumulation policies. sum(v, policy) and dot(u, v, policy) choose how the components are added:
+*  naive_sum      in the component type, from the first to the last (the default)
+*  widened_sum    in a wider type: float, float16 and bfloat16 in double, double in long double, and integers
+*                 in 64 bits. The result has the wider type.
+*  kahan_sum      in the component type, with Neumaier's compensation: the error doesn't grow with N
+*  pairwise_sum   in the component type, halving the range recursively: the error grows with log N
+*  sum(v) and dot(u, v) take accumulation_policy<T>::type for components of type T. Specialize it before any
+*  use to change the default of a type in the whole program:
+*      template <> struct accumulation_policy<float> { using type = widened_sum; };
+*  -ffast-math allows the compiler to cancel the compensation of kahan_sum.
+*/
+struct naive_sum {};
+struct widened_sum {};
+struct kahan_sum {};
+struct pairwise_sum {};
+template <typename P>
+concept __AccumulationPolicy = std::is_same_v<P, naive_sum> || std::is_same_v<P, widened_sum>
+                               || std::is_same_v<P, kahan_sum> || std::is_same_v<P, pairwise_sum>;
+template <typename T>
+struct accumulation_policy {
+    using type = naive_sum;
+};
+template <typename T>
+using accumulation_policy_t = typename accumulation_policy<T>::type;
+// Type in which the components are added: 16 bit types in float
+template <typename T>
+using __compute_t = std::conditional_t<is_half_float_v<T>, float, T>;
+// Type of widened_sum
+template <typename T>
+struct __widened { using type = T; };
+template <typename T> requires std::is_floating_point_v<T> || is_half_float_v<T>
+struct __widened<T> { using type = std::conditional_t<(sizeof(T) < sizeof(double)), double, long double>; };
+template <typename T> requires std::is_integral_v<T>
+struct __widened<T> { using type = std::conditional_t<std::is_signed_v<T>, long long, unsigned long long>; };
+template <typename T>
+struct __widened<std::complex<T>> { using type = std::complex<typename __widened<T>::type>; };
+template <typename T>
+using __widened_t = typename __widened<T>::type;
+// Type of the terms added with policy P
+template <typename P, typename T>
+using __accumulator_t = std::conditional_t<std::is_same_v<P, widened_sum>, __widened_t<T>, __compute_t<T>>;
+// s + x into s, with the rounding error added to c (Neumaier)
+template <typename T>
+inline constexpr void __neumaier(T &s, T &c, const T x) noexcept {
+    if constexpr (is_complex_v<T>) {
+        auto sr = s.real(), si = s.imag(), cr = c.real(), ci = c.imag();
+        __neumaier(sr, cr, x.real());
+        __neumaier(si, ci, x.imag());
+        s = T(sr, si);
+        c = T(cr, ci);
+    }
+    else if constexpr (std::is_floating_point_v<T>) {
+        const T t = s + x;
+        c += (s < 0 ? -s : s) >= (x < 0 ? -x : x) ? (s - t) + x : (x - t) + s;
+        s = t;
+    }
+    else s += x;
+}
+// term(b) + ... + term(e - 1) in halves, down to 8 terms
+template <typename F>
+inline constexpr auto __pairwise(const F &term, const std::size_t b, const std::size_t e) noexcept {
+    if (e - b <= 8) {
+        auto s = term(b);
+        for (std::size_t i = b + 1; i < e; ++i)
+            s += term(i);
+        return s;
+    }
+    const std::size_t m = b + (e - b) / 2;
+    return __pairwise(term, b, m) + __pairwise(term, m, e);
+}
+// term(0) + ... + term(N - 1) with policy P. The terms already have the type of the accumulator.
+template <typename P, std::size_t N, typename F>
+inline constexpr auto __accumulate(const F &term) noexcept {
+    if constexpr (std::is_same_v<P, pairwise_sum>)
+        return __pairwise(term, 0, N);
+    else if constexpr (std::is_same_v<P, kahan_sum>) {
+        auto s = term(0);
+        decltype(s) c = 0;
+        for (std::size_t i = 1; i < N; ++i)
+            __neumaier(s, c, term(i));
+        return s + c;
+    }
+    else {
+        auto s = term(0);
+        for (std::size_t i = 1; i < N; ++i)
+            s += term(i);
+        return s;
+    }
+}
+/*
 *  Utility functions
 */
-// Sumation of all elements
+// Sumation of all elements, in order in the component type
 template <typename E1, std::size_t N>
-inline constexpr auto sum(const __VecExpression<E1, N> &expr) noexcept {
-    auto Sum = expr[0];
-    for (std::size_t i = 1; i < N; ++i)
-        Sum += expr[i];
-    return Sum;
+inline constexpr auto __naive_sum(const __VecExpression<E1, N> &expr) noexcept {
+    if constexpr (N <= __unroll_limit) {
+        return [&]<std::size_t... I>(std::index_sequence<I...>) {
+            return (... + expr.template get<I>());
+        }(std::make_index_sequence<N>{});
+    }
+    else {
+        auto Sum = expr[0];
+        for (std::size_t i = 1; i < N; ++i)
+            Sum += expr[i];
+        return Sum;
+    }
 }
 // Specialization for N = 3
 template <typename E1>
-inline constexpr auto sum(const __VecExpression<E1, 3> &expr) noexcept {
-    return expr[0] + expr[1] + expr[2];
+inline constexpr auto __naive_sum(const __VecExpression<E1, 3> &expr) noexcept {
+    return expr.template get<0>() + expr.template get<1>() + expr.template get<2>();
 }
 // Specialization for N = 2
 template <typename E1>
-inline constexpr auto sum(const __VecExpression<E1, 2> &expr) noexcept {
-    return expr[0] + expr[1];
+inline constexpr auto __naive_sum(const __VecExpression<E1, 2> &expr) noexcept {
+    return expr.template get<0>() + expr.template get<1>();
+}
+// Sumation of all elements with an accumulation policy
+template <__AccumulationPolicy P, typename E1, std::size_t N>
+inline constexpr auto sum(const __VecExpression<E1, N> &expr, P) noexcept {
+    if constexpr (std::is_same_v<P, naive_sum>) return __naive_sum(expr);
+    else {
+        using A = __accumulator_t<P, std::remove_cvref_t<decltype(expr[0])>>;
+        return __accumulate<std::conditional_t<std::is_same_v<P, widened_sum>, naive_sum, P>, N>([&](const std::size_t i) {
+            return static_cast<A>(expr[i]);
+        });
+    }
+}
+// Sumation of all elements with the policy of their type
+template <typename E1, std::size_t N>
+inline constexpr auto sum(const __VecExpression<E1, N> &expr) noexcept {
+    return sum(expr, accumulation_policy_t<std::remove_cvref_t<decltype(expr[0])>>());
 }
 // Element-wise product
 template <typename E1, typename E2, std::size_t N>
@@ -83,10 +278,22 @@ class __VecElementWiseProduct : public __VecExpression<__VecElementWiseProduct<E
     const E1& _u;
     const E2& _v;
 public:
+    static constexpr std::size_t __cost = __cost_v<E1> + __cost_v<E2> + 1;
     constexpr __VecElementWiseProduct(const E1 &u, const E2 &v) noexcept : _u(u), _v(v) {};
     inline constexpr const auto operator[](const std::size_t i) const {
         return _u[i] * _v[i];
     }
+    template <std::size_t I>
+    inline constexpr const auto get() const noexcept {
+        return _u.template get<I>() * _v.template get<I>();
+    }
+    inline constexpr auto __factors(const std::size_t i) const {
+        return std::make_pair(_u[i], _v[i]);
+    }
+    template <std::size_t I>
+    inline constexpr auto __factors() const noexcept {
+        return std::make_pair(_u.template get<I>(), _v.template get<I>());
+    }
     static inline constexpr const std::size_t size() {
         return N;
     }
@@ -95,17 +302,70 @@ template <typename E1, typename E2, std::size_t N>
 inline constexpr __VecElementWiseProduct<E1, E2, N> ElemProd(__VecExpression<E1, N> const& u, __VecExpression<E2, N> const& v) noexcept {
     return __VecElementWiseProduct<E1, E2, N>(*static_cast<const E1*>(&u), *static_cast<const E2*>(&v));
 }
-// Dot Product
+// Square Norm. Each component is evaluated once, which matters for costly nodes such as norm2(u ^ v).
+template <typename E1, std::size_t N>
+inline constexpr auto norm2(const __VecExpression<E1, N> &expr) noexcept {
+    if constexpr (N <= __unroll_limit) {
+        const auto c = expr.template get<0>();
+        auto Sum = c * c;
+        __static_for<N - 1>([&](auto I) {
+            const auto c = expr.template get<I() + 1>();
+            Sum = __vec_fma(c, c, Sum);
+        });
+        return Sum;
+    }
+    else {
+        auto Sum = expr[0] * expr[0];
+        for (std::size_t i = 1; i < N; ++i) {
+            const auto c = expr[i];
+            Sum += c * c;
+        }
+        return Sum;
+    }
+}
+// Dot Product, in order in the component type
+template <typename E1, typename E2, std::size_t N>
+inline constexpr auto __naive_dot(const __VecExpression<E1, N> &u, const __VecExpression<E2, N> &v) noexcept {
+    using T1 = std::remove_cvref_t<decltype(u[0])>;
+    using T2 = std::remove_cvref_t<decltype(v[0])>;
+    // dot(u, u) is norm2(u), which evaluates each component of u once
+    if constexpr (std::is_same_v<E1, E2>) {
+        if (__same_object(u, v)) return norm2(u);
+    }
+    if constexpr (__use_fma && std::is_floating_point_v<T1> && std::is_same_v<T1, T2> && N <= __unroll_limit) {
+        // u0 v0 + u1 v1 + ... as a chain of multiply-adds
+        auto Sum = u.template get<0>() * v.template get<0>();
+        __static_for<N - 1>([&](auto I) {
+            Sum = __vec_fma(u.template get<I() + 1>(), v.template get<I() + 1>(), Sum);
+        });
+        return Sum;
+    }
+    else return __naive_sum(ElemProd(u, v));
+}
+// Dot Product with an accumulation policy. The products are taken in the type of the accumulator.
+template <__AccumulationPolicy P, typename E1, typename E2, std::size_t N>
+inline constexpr auto dot(const __VecExpression<E1, N> &u, const __VecExpression<E2, N> &v, P) noexcept {
+    if constexpr (std::is_same_v<P, naive_sum>) return __naive_dot(u, v);
+    else {
+        using A = __accumulator_t<P, std::remove_cvref_t<decltype(u[0] * v[0])>>;
+        return __accumulate<std::conditional_t<std::is_same_v<P, widened_sum>, naive_sum, P>, N>([&](const std::size_t i) {
+            return static_cast<A>(u[i]) * static_cast<A>(v[i]);
+        });
+    }
+}
+// Dot Product with the policy of the type of the products
 template <typename E1, typename E2, std::size_t N>
 inline constexpr auto dot(const __VecExpression<E1, N> &u, const __VecExpression<E2, N> &v) noexcept {
-    return sum(ElemProd(u, v));
+    return dot(u, v, accumulation_policy_t<std::remove_cvref_t<decltype(u[0] * v[0])>>());
 }
 // Cross Product
 template <typename E1, typename E2>
 class __VecCrossProduct : public __VecExpression<__VecCrossProduct<E1, E2>, 3> {
-    const E1& _u;
-    const E2& _v;
+    // Every component of u and v is read twice
+    __operand_t<E1, 2> _u;
+    __operand_t<E2, 2> _v;
 public:
+    static constexpr std::size_t __cost = 2 * (__cost_v<std::remove_cvref_t<decltype(_u)>> + __cost_v<std::remove_cvref_t<decltype(_v)>>) + 3;
     constexpr __VecCrossProduct(const E1 &u, const E2 &v) noexcept : _u(u), _v(v) {};
     inline constexpr const auto operator[](const std::size_t i) const {
         if (i == 0) return _u[1] * _v[2] - _u[2] * _v[1];
@@ -113,6 +373,12 @@ public:
         if (i == 2) return _u[0] * _v[1] - _u[1] * _v[0];
         return 0 * _u[0];
     }
+    template <std::size_t I>
+    inline constexpr const auto get() const noexcept {
+        if constexpr (I == 0) return _u.template get<1>() * _v.template get<2>() - _u.template get<2>() * _v.template get<1>();
+        if constexpr (I == 1) return _u.template get<2>() * _v.template get<0>() - _u.template get<0>() * _v.template get<2>();
+        if constexpr (I == 2) return _u.template get<0>() * _v.template get<1>() - _u.template get<1>() * _v.template get<0>();
+    }
     static inline constexpr const std::size_t size() {
         return 3;
     }
@@ -123,14 +389,9 @@ inline constexpr __VecCrossProduct<E1, E2> cross(const __VecExpression<E1, 3> &
 }
 template <typename E1, typename E2>
 inline constexpr auto cross(const __VecExpression<E1, 2> & u, const __VecExpression<E2, 2> &v) noexcept {
-    return u[0] * v[1] - u[1] * v[0];
+    return u.template get<0>() * v.template get<1>() - u.template get<1>() * v.template get<0>();
 }
 
-// Square Norm
-template <typename E1, std::size_t N>
-inline constexpr auto norm2(const __VecExpression<E1, N> &expr) noexcept {
-    return dot(expr, expr);
-}
 // Norm
 template <typename E1, std::size_t N>
 inline constexpr auto norm(const __VecExpression<E1, N> &expr) noexcept {
@@ -158,9 +419,49 @@ class __VecSum : public __VecExpression<__VecSum<E1, E2, N>, N> {
     const E1& _u;
     const E2& _v;
 public:
+    static constexpr std::size_t __cost = __cost_v<E1> + __cost_v<E2> + 1;
     constexpr __VecSum(const E1 &u, const E2 &v) noexcept : _u(u), _v(v) {};
     inline constexpr const auto operator[](const std::size_t i) const {
-        return _u[i] + _v[i];
+        if constexpr (__is_repeated_sum_v<E1, E2>) {
+            // (u + v) + v = u + 2 v
+            if (__same_object(_u.__right(), _v)) {
+                const auto b = _v[i];
+                return __vec_fma(decltype(b)(2), b, _u.__left()[i]);
+            }
+        }
+        if constexpr (__use_fma && __is_product_v<E1>) {
+            const auto [a, b] = _u.__factors(i);
+            return __vec_fma(a, b, _v[i]);
+        }
+        else if constexpr (__use_fma && __is_product_v<E2>) {
+            const auto [a, b] = _v.__factors(i);
+            return __vec_fma(a, b, _u[i]);
+        }
+        else return _u[i] + _v[i];
+    }
+    template <std::size_t I>
+    inline constexpr const auto get() const noexcept {
+        if constexpr (__is_repeated_sum_v<E1, E2>) {
+            if (__same_object(_u.__right(), _v)) {
+                const auto b = _v.template get<I>();
+                return __vec_fma(decltype(b)(2), b, _u.__left().template get<I>());
+            }
+        }
+        if constexpr (__use_fma && __is_product_v<E1>) {
+            const auto [a, b] = _u.template __factors<I>();
+            return __vec_fma(a, b, _v.template get<I>());
+        }
+        else if constexpr (__use_fma && __is_product_v<E2>) {
+            const auto [a, b] = _v.template __factors<I>();
+            return __vec_fma(a, b, _u.template get<I>());
+        }
+        else return _u.template get<I>() + _v.template get<I>();
+    }
+    inline constexpr const E1& __left() const noexcept {
+        return _u;
+    }
+    inline constexpr const E2& __right() const noexcept {
+        return _v;
     }
     static inline constexpr const std::size_t size() {
         return N;
@@ -176,10 +477,15 @@ template <typename E1, std::size_t N>
 class __LeftVecSum : public __VecExpression<__LeftVecSum<E1, N>, N> {
     const E1& _u;
 public:
+    static constexpr std::size_t __cost = __cost_v<E1>;
     constexpr __LeftVecSum(const E1 &u) noexcept : _u(u) {};
     inline constexpr const auto operator[](const std::size_t i) const {
         return _u[i];
     }
+    template <std::size_t I>
+    inline constexpr const auto get() const noexcept {
+        return _u.template get<I>();
+    }
     static inline constexpr const std::size_t size() {
         return N;
     }
@@ -194,9 +500,30 @@ class __VecSubtraction : public __VecExpression<__VecSubtraction<E1, E2, N>, N>
     const E1& _u;
     const E2& _v;
 public:
+    static constexpr std::size_t __cost = __cost_v<E1> + __cost_v<E2> + 1;
     constexpr __VecSubtraction(const E1 &u, const E2 &v) noexcept : _u(u), _v(v) {};
     inline constexpr const auto operator[](const std::size_t i) const {
-        return _u[i] - _v[i];
+        if constexpr (__use_fma && __is_product_v<E1>) {
+            const auto [a, b] = _u.__factors(i);
+            return __vec_fma(a, b, -_v[i]);
+        }
+        else if constexpr (__use_fma && __is_product_v<E2>) {
+            const auto [a, b] = _v.__factors(i);
+            return __vec_fma(-a, b, _u[i]);
+        }
+        else return _u[i] - _v[i];
+    }
+    template <std::size_t I>
+    inline constexpr const auto get() const noexcept {
+        if constexpr (__use_fma && __is_product_v<E1>) {
+            const auto [a, b] = _u.template __factors<I>();
+            return __vec_fma(a, b, -_v.template get<I>());
+        }
+        else if constexpr (__use_fma && __is_product_v<E2>) {
+            const auto [a, b] = _v.template __factors<I>();
+            return __vec_fma(-a, b, _u.template get<I>());
+        }
+        else return _u.template get<I>() - _v.template get<I>();
     }
     static inline constexpr const std::size_t size() {
         return N;
@@ -212,10 +539,18 @@ template <typename E1, std::size_t N>
 class __LeftVecSubtraction : public __VecExpression<__LeftVecSubtraction<E1, N>, N> {
     const E1& _u;
 public:
+    static constexpr std::size_t __cost = __cost_v<E1> + 1;
     constexpr __LeftVecSubtraction(const E1 &u) noexcept : _u(u) {};
     inline constexpr const auto operator[](const std::size_t i) const {
         return -_u[i];
     }
+    template <std::size_t I>
+    inline constexpr const auto get() const noexcept {
+        return -_u.template get<I>();
+    }
+    inline constexpr const E1& __operand() const noexcept {
+        return _u;
+    }
     static inline constexpr const std::size_t size() {
         return N;
     }
@@ -238,12 +573,30 @@ inline constexpr auto operator^(const __VecExpression<E1, N> &u, const __VecExpr
 template <typename E1, __Number E2, std::size_t N>
 class __LeftVecScalarProduct : public __VecExpression<__LeftVecScalarProduct<E1, E2, N>, N> {
     const E1& _u;
-    const E2& _v;
+    const E2 _v;
 public:
+    static constexpr std::size_t __cost = __cost_v<E1> + 1;
     constexpr __LeftVecScalarProduct(const E1 &u, const E2 &v) noexcept : _u(u), _v(v) {};
     inline constexpr const auto operator[](const std::size_t i) const {
         return _u[i] * _v;
     }
+    template <std::size_t I>
+    inline constexpr const auto get() const noexcept {
+        return _u.template get<I>() * _v;
+    }
+    inline constexpr auto __factors(const std::size_t i) const {
+        return std::make_pair(_u[i], _v);
+    }
+    template <std::size_t I>
+    inline constexpr auto __factors() const noexcept {
+        return std::make_pair(_u.template get<I>(), _v);
+    }
+    inline constexpr const E1& __vector() const noexcept {
+        return _u;
+    }
+    inline constexpr const E2& __scalar() const noexcept {
+        return _v;
+    }
     static inline constexpr const std::size_t size() {
         return N;
     }
@@ -255,12 +608,30 @@ inline constexpr __LeftVecScalarProduct<E1, E2, N> operator*(const E2 &v, const
 template <typename E1, __Number E2, std::size_t N>
 class __RightVecScalarProduct : public __VecExpression<__RightVecScalarProduct<E1, E2, N>, N> {
     const E1& _u;
-    const E2& _v;
+    const E2 _v;
 public:
+    static constexpr std::size_t __cost = __cost_v<E1> + 1;
     constexpr __RightVecScalarProduct(const E1 &u, const E2 &v) noexcept : _u(u), _v(v) {};
     inline constexpr const auto operator[](const std::size_t i) const {
         return _u[i] * _v;
     }
+    template <std::size_t I>
+    inline constexpr const auto get() const noexcept {
+        return _u.template get<I>() * _v;
+    }
+    inline constexpr auto __factors(const std::size_t i) const {
+        return std::make_pair(_u[i], _v);
+    }
+    template <std::size_t I>
+    inline constexpr auto __factors() const noexcept {
+        return std::make_pair(_u.template get<I>(), _v);
+    }
+    inline constexpr const E1& __vector() const noexcept {
+        return _u;
+    }
+    inline constexpr const E2& __scalar() const noexcept {
+        return _v;
+    }
     static inline constexpr const std::size_t size() {
         return N;
     }
@@ -275,10 +646,15 @@ class __VecElementWiseDivision : public __VecExpression<__VecElementWiseDivision
     const E1& _u;
     const E2& _v;
 public:
+    static constexpr std::size_t __cost = __cost_v<E1> + __cost_v<E2> + 1;
     constexpr __VecElementWiseDivision(const E1 &u, const E2 &v) noexcept : _u(u), _v(v) {};
     inline constexpr const auto operator[](const std::size_t i) const {
         return _u[i] / _v[i];
     }
+    template <std::size_t I>
+    inline constexpr const auto get() const noexcept {
+        return _u.template get<I>() / _v.template get<I>();
+    }
     static inline constexpr const std::size_t size() {
         return N;
     }
@@ -291,12 +667,17 @@ inline constexpr __VecElementWiseDivision<E1, E2, N> operator/(__VecExpression<E
 template <typename E1, __Number E2, std::size_t N>
 class __VecScalarDivision : public __VecExpression<__VecScalarDivision<E1, E2, N>, N> {
     const E1& _u;
-    const E2& _v;
+    const E2 _v;
 public:
+    static constexpr std::size_t __cost = __cost_v<E1> + 1;
     constexpr __VecScalarDivision(const E1 &u, const E2 &v) noexcept : _u(u), _v(v) {};
     inline constexpr const auto operator[](const std::size_t i) const {
         return _u[i] / _v;
     }
+    template <std::size_t I>
+    inline constexpr const auto get() const noexcept {
+        return _u.template get<I>() / _v;
+    }
     static inline constexpr const std::size_t size() {
         return N;
     }
@@ -308,13 +689,19 @@ inline constexpr __VecScalarDivision<E1, E2, N> operator/(const __VecExpression<
 // Normalization
 template <typename E1, typename E2, std::size_t N>
 class __VecNormalization : public __VecExpression<__VecNormalization<E1, E2, N>, N> {
-    const E1& _u;
+    // u is read by the norm and again by every component
+    __operand_t<E1, 2> _u;
     const E2 Norm;
 public:
-    constexpr __VecNormalization(const E1 &u) noexcept : _u(u), Norm(norm(u)) {};
+    static constexpr std::size_t __cost = __cost_v<std::remove_cvref_t<decltype(_u)>> + 1;
+    constexpr __VecNormalization(const E1 &u) noexcept : _u(u), Norm(norm(_u)) {};
     inline constexpr const auto operator[](const std::size_t i) const {
         return _u[i] / Norm;
     }
+    template <std::size_t I>
+    inline constexpr const auto get() const noexcept {
+        return _u.template get<I>() / Norm;
+    }
     static inline constexpr const std::size_t size() {
         return N;
     }
@@ -324,6 +711,64 @@ inline constexpr auto unit(const __VecExpression<E1, N> &u) noexcept {
     return __VecNormalization<E1, decltype(norm(u)), N>(*static_cast<const E1*>(&u));
 }
 /*
+*  Simplification
+*  Overloads for particular shapes of the operands, chosen at compile time, that rewrite the tree
+*  before it is evaluated. They only build nodes over operands that already exist, never over
+*  temporaries of their own, so the result can be stored in the same full expression as before.
+*/
+// -(-u) = u
+template <typename E1, std::size_t N>
+inline constexpr const E1& operator-(const __LeftVecSubtraction<E1, N> &u) noexcept {
+    return u.__operand();
+}
+// u + (-v) = u - v
+template <typename E1, typename E2, std::size_t N>
+inline constexpr __VecSubtraction<E1, E2, N> operator+(const __VecExpression<E1, N> &u, const __LeftVecSubtraction<E2, N> &v) noexcept {
+    return __VecSubtraction<E1, E2, N>(*static_cast<const E1*>(&u), v.__operand());
+}
+// (-u) + v = v - u
+template <typename E1, typename E2, std::size_t N>
+inline constexpr __VecSubtraction<E2, E1, N> operator+(const __LeftVecSubtraction<E1, N> &u, const __VecExpression<E2, N> &v) noexcept {
+    return __VecSubtraction<E2, E1, N>(*static_cast<const E2*>(&v), u.__operand());
+}
+// (-u) + (-v) = (-u) - v
+template <typename E1, typename E2, std::size_t N>
+inline constexpr __VecSubtraction<__LeftVecSubtraction<E1, N>, E2, N> operator+(const __LeftVecSubtraction<E1, N> &u, const __LeftVecSubtraction<E2, N> &v) noexcept {
+    return __VecSubtraction<__LeftVecSubtraction<E1, N>, E2, N>(u, v.__operand());
+}
+// u - (-v) = u + v
+template <typename E1, typename E2, std::size_t N>
+inline constexpr __VecSum<E1, E2, N> operator-(const __VecExpression<E1, N> &u, const __LeftVecSubtraction<E2, N> &v) noexcept {
+    return __VecSum<E1, E2, N>(*static_cast<const E1*>(&u), v.__operand());
+}
+// Scalar chains fold into a single scalar: a (b u) = (a b) u. The scalars are multiplied first,
+// so the result may differ from the nested product in the last bit.
+template <__Number S, typename E1, __Number E2, std::size_t N>
+inline constexpr auto operator*(const S &a, const __LeftVecScalarProduct<E1, E2, N> &u) noexcept {
+    return __LeftVecScalarProduct<E1, decltype(a * u.__scalar()), N>(u.__vector(), a * u.__scalar());
+}
+template <__Number S, typename E1, __Number E2, std::size_t N>
+inline constexpr auto operator*(const S &a, const __RightVecScalarProduct<E1, E2, N> &u) noexcept {
+    return __LeftVecScalarProduct<E1, decltype(a * u.__scalar()), N>(u.__vector(), a * u.__scalar());
+}
+template <typename E1, __Number E2, __Number S, std::size_t N>
+inline constexpr auto operator*(const __LeftVecScalarProduct<E1, E2, N> &u, const S &a) noexcept {
+    return __RightVecScalarProduct<E1, decltype(u.__scalar() * a), N>(u.__vector(), u.__scalar() * a);
+}
+template <typename E1, __Number E2, __Number S, std::size_t N>
+inline constexpr auto operator*(const __RightVecScalarProduct<E1, E2, N> &u, const S &a) noexcept {
+    return __RightVecScalarProduct<E1, decltype(u.__scalar() * a), N>(u.__vector(), u.__scalar() * a);
+}
+// -(a u) = (-a) u, the sign goes to the scalar
+template <typename E1, __Number E2, std::size_t N> requires (!std::is_unsigned_v<E2>)
+inline constexpr auto operator-(const __LeftVecScalarProduct<E1, E2, N> &u) noexcept {
+    return __LeftVecScalarProduct<E1, decltype(-u.__scalar()), N>(u.__vector(), -u.__scalar());
+}
+template <typename E1, __Number E2, std::size_t N> requires (!std::is_unsigned_v<E2>)
+inline constexpr auto operator-(const __RightVecScalarProduct<E1, E2, N> &u) noexcept {
+    return __RightVecScalarProduct<E1, decltype(-u.__scalar()), N>(u.__vector(), -u.__scalar());
+}
+/*
 *  Vector Classes
 */
 template <__Number T>
@@ -347,7 +792,7 @@ public:
 
     template <typename E>
     inline constexpr vector3D(const __VecExpression<E, 3> &expr) noexcept {
-        x = expr[0]; y = expr[1]; z = expr[2];
+        x = expr.template get<0>(); y = expr.template get<1>(); z = expr.template get<2>();
     }
     inline constexpr const T& operator[](const std::size_t i) const {
         if (i == 0) return x;
@@ -361,21 +806,35 @@ public:
         else if (i == 2) return z;
         else throw std::out_of_range("vector3D: Index out of range");
     }
+    template <std::size_t I>
+    inline constexpr const T& get() const noexcept {
+        static_assert(I < 3, "vector3D: Index out of range");
+        if constexpr (I == 0) return x;
+        else if constexpr (I == 1) return y;
+        else return z;
+    }
+    template <std::size_t I>
+    inline constexpr T& get() noexcept {
+        static_assert(I < 3, "vector3D: Index out of range");
+        if constexpr (I == 0) return x;
+        else if constexpr (I == 1) return y;
+        else return z;
+    }
     /*
     *  OPERATORS
     */
     template <typename E>
     inline constexpr vector3D<T>& operator+=(const __VecExpression<E, 3>& expr) noexcept {
-        x += expr[0];
-        y += expr[1];
-        z += expr[2];
+        x += expr.template get<0>();
+        y += expr.template get<1>();
+        z += expr.template get<2>();
         return *this;
     }
     template <typename E>
     inline constexpr vector3D<T>& operator-=(const __VecExpression<E, 3>& expr) noexcept {
-        x -= expr[0];
-        y -= expr[1];
-        z -= expr[2];
+        x -= expr.template get<0>();
+        y -= expr.template get<1>();
+        z -= expr.template get<2>();
         return *this;
     }
     template <__Number E>
@@ -394,16 +853,16 @@ public:
     }
     template <typename E>
     inline constexpr vector3D<T>& operator/=(const __VecExpression<E, 3>& expr) noexcept {
-        x /= expr[0];
-        y /= expr[1];
-        z /= expr[2];
+        x /= expr.template get<0>();
+        y /= expr.template get<1>();
+        z /= expr.template get<2>();
         return *this;
     }
     template <typename E>
     inline constexpr vector3D<T>& operator^=(const __VecExpression<E, 3>& expr) noexcept {
-        T xtemp = y * expr[2] - z * expr[1];
-        T ytemp = z * expr[0] - x * expr[2];
-        T ztemp = x * expr[1] - y * expr[0];
+        T xtemp = y * expr.template get<2>() - z * expr.template get<1>();
+        T ytemp = z * expr.template get<0>() - x * expr.template get<2>();
+        T ztemp = x * expr.template get<1>() - y * expr.template get<0>();
         x =  xtemp;
         y =  ytemp;
         z =  ztemp;
@@ -441,7 +900,7 @@ public:
 
     template <typename E>
     inline constexpr vector2D(const __VecExpression<E, 2> &expr) noexcept {
-        x = expr[0]; y = expr[1];
+        x = expr.template get<0>(); y = expr.template get<1>();
     }
     inline constexpr const T& operator[](const std::size_t i) const {
         switch (i) {
@@ -457,19 +916,31 @@ public:
         default: throw std::out_of_range("vector2D: Index out of range");
         }
     }
+    template <std::size_t I>
+    inline constexpr const T& get() const noexcept {
+        static_assert(I < 2, "vector2D: Index out of range");
+        if constexpr (I == 0) return x;
+        else return y;
+    }
+    template <std::size_t I>
+    inline constexpr T& get() noexcept {
+        static_assert(I < 2, "vector2D: Index out of range");
+        if constexpr (I == 0) return x;
+        else return y;
+    }
     /*
     *  OPERATORS
     */
     template <typename E>
     inline constexpr vector2D<T>& operator+=(const __VecExpression<E, 2>& expr) noexcept {
-        x += expr[0];
-        y += expr[1];
+        x += expr.template get<0>();
+        y += expr.template get<1>();
         return *this;
     }
     template <typename E>
     inline constexpr vector2D<T>& operator-=(const __VecExpression<E, 2>& expr) noexcept {
-        x -= expr[0];
-        y -= expr[1];
+        x -= expr.template get<0>();
+        y -= expr.template get<1>();
         return *this;
     }
     template <__Number E>
@@ -486,8 +957,8 @@ public:
     }
     template <typename E>
     inline constexpr vector2D<T>& operator/=(const __VecExpression<E, 2>& expr) noexcept {
-        x /= expr[0];
-        y /= expr[1];
+        x /= expr.template get<0>();
+        y /= expr.template get<1>();
         return *this;
     }
     inline constexpr const T norm2() const noexcept {
@@ -501,23 +972,39 @@ public:
         return *this;
     }
 };
+// Alignment of the inline storage of vectorND.
+// The largest power of two (up to a 64 byte cache line) that divides the size of the data block,
+// so that the block never straddles more cache lines or SIMD registers than it needs to.
+template <typename T, std::size_t N>
+inline constexpr std::size_t __storage_alignment() {
+    std::size_t align = alignof(T);
+    while (align < 64 && (sizeof(T) * N) % (2 * align) == 0)
+        align *= 2;
+    return align;
+}
 template <__Number T, std::size_t N>
 class vectorND : public __VecExpression<vectorND<T, N>, N> {
 private:
-    std::vector<T> data;
+    // The size is known at compile time, so the components live inline. No heap allocations.
+    alignas(__storage_alignment<T, N>()) std::array<T, N> data;
 public:
     static inline constexpr const std::size_t size() {
         return N;
     }
-    std::vector<T>::iterator begin() { return data.begin();}
-    std::vector<T>::iterator end()   { return data.end();}
+    inline constexpr typename std::array<T, N>::iterator begin() noexcept { return data.begin();}
+    inline constexpr typename std::array<T, N>::iterator end() noexcept { return data.end();}
+    inline constexpr typename std::array<T, N>::const_iterator begin() const noexcept { return data.begin();}
+    inline constexpr typename std::array<T, N>::const_iterator end() const noexcept { return data.end();}
 
     constexpr vectorND() noexcept = default;
     constexpr vectorND(const vectorND& other) noexcept = default;
     constexpr vectorND(vectorND&& other) noexcept = default;
-    constexpr vectorND(const T value) noexcept : data(N, value) {}
+    constexpr vectorND(const T value) noexcept {
+        data.fill(value);
+    }
     template <typename... Args>
-    constexpr vectorND(const Args&... args) noexcept : data {args...} {
+    requires (sizeof...(Args) > 1 && (std::is_convertible_v<Args, T> && ...))
+    constexpr vectorND(const Args&... args) noexcept : data {static_cast<T>(args)...} {
         static_assert(sizeof...(args) == N, "vectorND: Number of arguments does not match the size of the vector.");
     }
     constexpr vectorND& operator=(const vectorND& other) noexcept = default;
@@ -526,13 +1013,23 @@ public:
     template <typename... Args>
     inline constexpr void load(const Args&... args) noexcept {
         static_assert(sizeof...(args) == N, "vectorND: Number of arguments does not match the size of the vector.");
-        data = {args...};
+        data = {static_cast<T>(args)...};
+    }
+private:
+    // op(data[i], expr[i]) for every component, unrolled at compile time for small vectors
+    template <typename E, typename Op>
+    inline constexpr void __apply(const __VecExpression<E, N> &expr, Op op) noexcept {
+        if constexpr (N <= __unroll_limit)
+            __static_for<N>([&](auto I) { op(std::get<I()>(data), expr.template get<I()>()); });
+        else
+            for (std::size_t i = 0; i < N; ++i)
+                op(data[i], expr[i]);
     }
+public:
 
     template <typename E>
     inline constexpr vectorND(const __VecExpression<E, N> &expr) noexcept {
-        for (std::size_t i = 0; i < N; ++i)
-            data[i] = expr[i];
+        __apply(expr, [](T &a, const auto b) { a = b; });
     }
     inline constexpr const T& operator[](const std::size_t i) const {
         return data[i];
@@ -540,19 +1037,25 @@ public:
     inline constexpr T& operator[](const std::size_t i) {
         return data[i];
     }
+    template <std::size_t I>
+    inline constexpr const T& get() const noexcept {
+        return std::get<I>(data);
+    }
+    template <std::size_t I>
+    inline constexpr T& get() noexcept {
+        return std::get<I>(data);
+    }
     /*
     *  OPERATORS
     */
     template <typename E>
     inline constexpr vectorND<T, N>& operator+=(const __VecExpression<E, N>& expr) noexcept {
-        for (std::size_t i = 0; i < N; ++i)
-            data[i] += expr[i];
+        __apply(expr, [](T &a, const auto b) { a += b; });
         return *this;
     }
     template <typename E>
     inline constexpr vectorND<T, N>& operator-=(const __VecExpression<E, N>& expr) noexcept {
-        for (std::size_t i = 0; i < N; ++i)
-            data[i] -= expr[i];
+        __apply(expr, [](T &a, const auto b) { a -= b; });
         return *this;
     }
     template <__Number E>
@@ -569,8 +1072,7 @@ public:
     }
     template <typename E>
     inline constexpr vectorND<T, N>& operator/=(const __VecExpression<E, N>& expr) noexcept {
-        for (std::size_t i = 0; i < N; ++i)
-            data[i] /= expr[i];
+        __apply(expr, [](T &a, const auto b) { a /= b; });
         return *this;
     }
     inline constexpr const T norm2() const noexcept {
@@ -583,4 +1085,10 @@ public:
         *this /= norm();
         return *this;
     }
-};
\ No newline at end of file
+};
+// Evaluates an expression into a vector. Nodes read a vector with plain loads, so eval() also marks
+// a subexpression that should be computed only once.
+template <typename E, std::size_t N>
+inline constexpr __eval_t<E, N> eval(const __VecExpression<E, N> &expr) noexcept {
+    return __eval_t<E, N>(expr);
+}
@@ -0,0 +1,605 @@
+#pragma once
+#include <new>
+#include <limits>
+#include <stdexcept>
+#include <utility>
+#include "vector.h"
+
+/*
+ * This file is part of the Vector3D distribution (https://github.com/cdelv/Vector3D).
+ * Copyright (c) 2022 Carlos Andres del Valle.
+ *
+ * Vector3D is under the terms of the BSD-3 license. We welcome feedback and contributions.
+ *
+ * you should have received a copy of the BSD3 Public License
+ * along with this program. If not, see <https://github.com/cdelv/Vector3D> LICENSE.
+ *
+ *
+ * This library requires C++20.
+*/
+
+// Tell the compiler that the iterations of the following loop are independent.
+// Array expressions only read and write element i on iteration i, so this is always true for them.
+#if defined(__clang__)
+#define __VECTOR3D_IVDEP _Pragma("clang loop vectorize(assume_safety)")
+#elif defined(__GNUC__)
+#define __VECTOR3D_IVDEP _Pragma("GCC ivdep")
+#else
+#define __VECTOR3D_IVDEP
+#endif
+
+// Allocator for the component arrays. Every array starts on a cache line.
+template <typename T, std::size_t Align = 64>
+struct __AlignedAllocator {
+    using value_type = T;
+    template <typename U>
+    struct rebind {
+        using other = __AlignedAllocator<U, Align>;
+    };
+    constexpr __AlignedAllocator() noexcept = default;
+    template <typename U>
+    constexpr __AlignedAllocator(const __AlignedAllocator<U, Align>&) noexcept {}
+
+    inline T* allocate(const std::size_t n) {
+        if (n > std::numeric_limits<std::size_t>::max() / sizeof(T))
+            throw std::bad_array_new_length();
+        return static_cast<T*>(::operator new(n * sizeof(T), std::align_val_t(Align)));
+    }
+    inline void deallocate(T* p, const std::size_t) noexcept {
+        ::operator delete(p, std::align_val_t(Align));
+    }
+    template <typename U>
+    inline constexpr bool operator==(const __AlignedAllocator<U, Align>&) const noexcept {
+        return true;
+    }
+};
+/*
+*  Expression templates over whole arrays of vectors.
+*  operator[](i) returns the i-th vector of the result by value. Assigning an expression to an array
+*  evaluates every node for element i in a single loop, so the whole expression is fused in one pass.
+*/
+template <typename E, std::size_t N>
+class __ArrayExpression {
+public:
+    inline constexpr auto operator[](const std::size_t i) const {
+        return static_cast<E const&>(*this)[i];
+    }
+    inline constexpr std::size_t size() const {
+        return static_cast<E const&>(*this).size();
+    }
+};
+// Both operands of a binary node must have the same size, the size of the node
+template <typename E1, typename E2>
+inline constexpr void __check_sizes(const E1 &u, const E2 &v) {
+    if (u.size() != v.size()) throw std::length_error("Array expression: Size mismatch");
+}
+// Sum
+template <typename E1, typename E2, std::size_t N>
+class __ArraySum : public __ArrayExpression<__ArraySum<E1, E2, N>, N> {
+    const E1& _u;
+    const E2& _v;
+public:
+    constexpr __ArraySum(const E1 &u, const E2 &v) : _u(u), _v(v) {
+        __check_sizes(u, v);
+    }
+    inline constexpr auto operator[](const std::size_t i) const {
+        return eval(_u[i] + _v[i]);
+    }
+    inline constexpr std::size_t size() const {
+        return _u.size();
+    }
+};
+template <typename E1, typename E2, std::size_t N>
+inline constexpr __ArraySum<E1, E2, N> operator+(const __ArrayExpression<E1, N> &u, const __ArrayExpression<E2, N> &v) {
+    return __ArraySum<E1, E2, N>(*static_cast<const E1*>(&u), *static_cast<const E2*>(&v));
+}
+// Subtraction
+template <typename E1, typename E2, std::size_t N>
+class __ArraySubtraction : public __ArrayExpression<__ArraySubtraction<E1, E2, N>, N> {
+    const E1& _u;
+    const E2& _v;
+public:
+    constexpr __ArraySubtraction(const E1 &u, const E2 &v) : _u(u), _v(v) {
+        __check_sizes(u, v);
+    }
+    inline constexpr auto operator[](const std::size_t i) const {
+        return eval(_u[i] - _v[i]);
+    }
+    inline constexpr std::size_t size() const {
+        return _u.size();
+    }
+};
+template <typename E1, typename E2, std::size_t N>
+inline constexpr __ArraySubtraction<E1, E2, N> operator-(const __ArrayExpression<E1, N> &u, const __ArrayExpression<E2, N> &v) {
+    return __ArraySubtraction<E1, E2, N>(*static_cast<const E1*>(&u), *static_cast<const E2*>(&v));
+}
+// -v operator
+template <typename E1, std::size_t N>
+class __LeftArraySubtraction : public __ArrayExpression<__LeftArraySubtraction<E1, N>, N> {
+    const E1& _u;
+public:
+    constexpr __LeftArraySubtraction(const E1 &u) noexcept : _u(u) {};
+    inline constexpr auto operator[](const std::size_t i) const {
+        return eval(-_u[i]);
+    }
+    inline constexpr std::size_t size() const {
+        return _u.size();
+    }
+};
+template <typename E1, std::size_t N>
+inline constexpr __LeftArraySubtraction<E1, N> operator-(const __ArrayExpression<E1, N> &u) noexcept {
+    return __LeftArraySubtraction<E1, N>(*static_cast<const E1*>(&u));
+}
+// Scalar multiplication
+// The scalar is stored by value. A reference could alias the output arrays and block vectorization.
+template <typename E1, __Number E2, std::size_t N>
+class __ArrayScalarProduct : public __ArrayExpression<__ArrayScalarProduct<E1, E2, N>, N> {
+    const E1& _u;
+    const E2 _v;
+public:
+    constexpr __ArrayScalarProduct(const E1 &u, const E2 &v) noexcept : _u(u), _v(v) {};
+    inline constexpr auto operator[](const std::size_t i) const {
+        return eval(_v * _u[i]);
+    }
+    inline constexpr std::size_t size() const {
+        return _u.size();
+    }
+};
+template <typename E1, __Number E2, std::size_t N>
+inline constexpr __ArrayScalarProduct<E1, E2, N> operator*(const E2 &v, const __ArrayExpression<E1, N> &u) noexcept {
+    return __ArrayScalarProduct<E1, E2, N>(*static_cast<const E1*>(&u), v);
+}
+template <typename E1, __Number E2, std::size_t N>
+inline constexpr __ArrayScalarProduct<E1, E2, N> operator*(const __ArrayExpression<E1, N> &u, const E2 &v) noexcept {
+    return __ArrayScalarProduct<E1, E2, N>(*static_cast<const E1*>(&u), v);
+}
+// Scalar Division
+template <typename E1, __Number E2, std::size_t N>
+class __ArrayScalarDivision : public __ArrayExpression<__ArrayScalarDivision<E1, E2, N>, N> {
+    const E1& _u;
+    const E2 _v;
+public:
+    constexpr __ArrayScalarDivision(const E1 &u, const E2 &v) noexcept : _u(u), _v(v) {};
+    inline constexpr auto operator[](const std::size_t i) const {
+        return eval(_u[i] / _v);
+    }
+    inline constexpr std::size_t size() const {
+        return _u.size();
+    }
+};
+template <typename E1, __Number E2, std::size_t N>
+inline constexpr __ArrayScalarDivision<E1, E2, N> operator/(const __ArrayExpression<E1, N> &u, const E2 &v) noexcept {
+    return __ArrayScalarDivision<E1, E2, N>(*static_cast<const E1*>(&u), v);
+}
+// Element-wise product
+template <typename E1, typename E2, std::size_t N>
+class __ArrayElementWiseProduct : public __ArrayExpression<__ArrayElementWiseProduct<E1, E2, N>, N> {
+    const E1& _u;
+    const E2& _v;
+public:
+    constexpr __ArrayElementWiseProduct(const E1 &u, const E2 &v) : _u(u), _v(v) {
+        __check_sizes(u, v);
+    }
+    inline constexpr auto operator[](const std::size_t i) const {
+        return eval(ElemProd(_u[i], _v[i]));
+    }
+    inline constexpr std::size_t size() const {
+        return _u.size();
+    }
+};
+template <typename E1, typename E2, std::size_t N>
+inline constexpr __ArrayElementWiseProduct<E1, E2, N> ElemProd(const __ArrayExpression<E1, N> &u, const __ArrayExpression<E2, N> &v) {
+    return __ArrayElementWiseProduct<E1, E2, N>(*static_cast<const E1*>(&u), *static_cast<const E2*>(&v));
+}
+// Element-wise division
+template <typename E1, typename E2, std::size_t N>
+class __ArrayElementWiseDivision : public __ArrayExpression<__ArrayElementWiseDivision<E1, E2, N>, N> {
+    const E1& _u;
+    const E2& _v;
+public:
+    constexpr __ArrayElementWiseDivision(const E1 &u, const E2 &v) : _u(u), _v(v) {
+        __check_sizes(u, v);
+    }
+    inline constexpr auto operator[](const std::size_t i) const {
+        return eval(_u[i] / _v[i]);
+    }
+    inline constexpr std::size_t size() const {
+        return _u.size();
+    }
+};
+template <typename E1, typename E2, std::size_t N>
+inline constexpr __ArrayElementWiseDivision<E1, E2, N> operator/(const __ArrayExpression<E1, N> &u, const __ArrayExpression<E2, N> &v) {
+    return __ArrayElementWiseDivision<E1, E2, N>(*static_cast<const E1*>(&u), *static_cast<const E2*>(&v));
+}
+// Cross Product
+template <typename E1, typename E2>
+class __ArrayCrossProduct : public __ArrayExpression<__ArrayCrossProduct<E1, E2>, 3> {
+    const E1& _u;
+    const E2& _v;
+public:
+    constexpr __ArrayCrossProduct(const E1 &u, const E2 &v) : _u(u), _v(v) {
+        __check_sizes(u, v);
+    }
+    inline constexpr auto operator[](const std::size_t i) const {
+        return eval(cross(_u[i], _v[i]));
+    }
+    inline constexpr std::size_t size() const {
+        return _u.size();
+    }
+};
+template <typename E1, typename E2>
+inline constexpr __ArrayCrossProduct<E1, E2> cross(const __ArrayExpression<E1, 3> &u, const __ArrayExpression<E2, 3> &v) {
+    return __ArrayCrossProduct<E1, E2>(*static_cast<const E1*>(&u), *static_cast<const E2*>(&v));
+}
+template <typename E1, typename E2>
+inline constexpr __ArrayCrossProduct<E1, E2> operator^(const __ArrayExpression<E1, 3> &u, const __ArrayExpression<E2, 3> &v) {
+    return cross(u, v);
+}
+// Unit vectors
+template <typename E1, std::size_t N>
+class __ArrayUnit : public __ArrayExpression<__ArrayUnit<E1, N>, N> {
+    const E1& _u;
+public:
+    constexpr __ArrayUnit(const E1 &u) noexcept : _u(u) {};
+    inline constexpr auto operator[](const std::size_t i) const {
+        return eval(unit(_u[i]));
+    }
+    inline constexpr std::size_t size() const {
+        return _u.size();
+    }
+};
+template <typename E1, std::size_t N>
+inline constexpr __ArrayUnit<E1, N> unit(const __ArrayExpression<E1, N> &u) noexcept {
+    return __ArrayUnit<E1, N>(*static_cast<const E1*>(&u));
+}
+/*
+*  Structure of arrays container for vector3D
+*/
+// Reference to one element of a vector3DArray. It behaves like a vector3D whose components live in the array.
+template <__Number T>
+class __Vec3DRef : public __VecExpression<__Vec3DRef<T>, 3> {
+public:
+    T &x, &y, &z;
+    static inline constexpr const std::size_t size() {
+        return 3;
+    }
+
+    constexpr __Vec3DRef(T &x_ref, T &y_ref, T &z_ref) noexcept : x(x_ref), y(y_ref), z(z_ref) {}
+    constexpr __Vec3DRef(const __Vec3DRef& other) noexcept = default;
+    inline constexpr __Vec3DRef& operator=(const __Vec3DRef& other) noexcept {
+        x = other.x; y = other.y; z = other.z;
+        return *this;
+    }
+    // The expression is evaluated before the store, it may read the element it is assigned to.
+    template <typename E>
+    inline constexpr __Vec3DRef& operator=(const __VecExpression<E, 3> &expr) noexcept {
+        const T x_val = expr.template get<0>(), y_val = expr.template get<1>(), z_val = expr.template get<2>();
+        x = x_val; y = y_val; z = z_val;
+        return *this;
+    }
+    inline constexpr void load(const T x_val, const T y_val, const T z_val) noexcept {
+        x = x_val; y = y_val; z = z_val;
+    }
+    inline constexpr operator vector3D<T>() const noexcept {
+        return vector3D<T>(x, y, z);
+    }
+    inline constexpr const T& operator[](const std::size_t i) const {
+        if (i == 0) return x;
+        else if (i == 1) return y;
+        else if (i == 2) return z;
+        else throw std::out_of_range("vector3DArray: Index out of range");
+    }
+    inline constexpr T& operator[](const std::size_t i) {
+        if (i == 0) return x;
+        else if (i == 1) return y;
+        else if (i == 2) return z;
+        else throw std::out_of_range("vector3DArray: Index out of range");
+    }
+    template <std::size_t I>
+    inline constexpr const T& get() const noexcept {
+        static_assert(I < 3, "vector3DArray: Index out of range");
+        if constexpr (I == 0) return x;
+        else if constexpr (I == 1) return y;
+        else return z;
+    }
+    template <std::size_t I>
+    inline constexpr T& get() noexcept {
+        static_assert(I < 3, "vector3DArray: Index out of range");
+        if constexpr (I == 0) return x;
+        else if constexpr (I == 1) return y;
+        else return z;
+    }
+    /*
+    *  OPERATORS
+    */
+    template <typename E>
+    inline constexpr __Vec3DRef& operator+=(const __VecExpression<E, 3>& expr) noexcept {
+        return *this = *this + expr;
+    }
+    template <typename E>
+    inline constexpr __Vec3DRef& operator-=(const __VecExpression<E, 3>& expr) noexcept {
+        return *this = *this - expr;
+    }
+    template <__Number E>
+    inline constexpr __Vec3DRef& operator*=(const E& a) noexcept {
+        x *= a;
+        y *= a;
+        z *= a;
+        return *this;
+    }
+    template <__Number E>
+    inline constexpr __Vec3DRef& operator/=(const E& a) noexcept {
+        x /= a;
+        y /= a;
+        z /= a;
+        return *this;
+    }
+    template <typename E>
+    inline constexpr __Vec3DRef& operator/=(const __VecExpression<E, 3>& expr) noexcept {
+        return *this = *this / expr;
+    }
+    template <typename E>
+    inline constexpr __Vec3DRef& operator^=(const __VecExpression<E, 3>& expr) noexcept {
+        return *this = cross(*this, expr);
+    }
+    inline constexpr const T norm2() const noexcept {
+        return dot(*this, *this);
+    }
+    inline constexpr const T norm() const noexcept {
+        return std::sqrt(norm2());
+    }
+    inline constexpr const __Vec3DRef& unit() noexcept {
+        *this /= norm();
+        return *this;
+    }
+};
+// The x, y and z components are stored in separate arrays. Each array is aligned to a cache line
+// and padded to a whole number of cache lines, so the three of them share a single allocation.
+template <__Number T>
+class vector3DArray : public __ArrayExpression<vector3DArray<T>, 3> {
+private:
+    static constexpr std::size_t __lane = 64 / sizeof(T) > 0 ? 64 / sizeof(T) : 1;
+    std::vector<T, __AlignedAllocator<T>> data;
+    std::size_t n = 0;
+    std::size_t stride = 0;
+
+    static inline constexpr std::size_t __padded(const std::size_t count) noexcept {
+        return (count + __lane - 1) / __lane * __lane;
+    }
+    template <typename E>
+    inline void __assign(const E &expr) noexcept {
+        T* X = x();
+        T* Y = y();
+        T* Z = z();
+        __VECTOR3D_IVDEP
+        for (std::size_t i = 0; i < n; ++i) {
+            const auto v = expr[i];
+            X[i] = v.x; Y[i] = v.y; Z[i] = v.z;
+        }
+    }
+public:
+    inline std::size_t size() const noexcept {
+        return n;
+    }
+
+    vector3DArray() = default;
+    vector3DArray(const vector3DArray& other) = default;
+    vector3DArray(vector3DArray&& other) noexcept = default;
+    vector3DArray& operator=(const vector3DArray& other) = default;
+    vector3DArray& operator=(vector3DArray&& other) noexcept = default;
+    explicit vector3DArray(const std::size_t size) : data(3 * __padded(size)), n(size), stride(__padded(size)) {}
+    vector3DArray(const std::size_t size, const vector3D<T> &value) : vector3DArray(size) {
+        std::fill(x(), x() + n, value.x);
+        std::fill(y(), y() + n, value.y);
+        std::fill(z(), z() + n, value.z);
+    }
+    // Conversion from an array of structs
+    explicit vector3DArray(const std::vector<vector3D<T>> &aos) : vector3DArray(aos.size()) {
+        for (std::size_t i = 0; i < n; ++i) {
+            x()[i] = aos[i].x; y()[i] = aos[i].y; z()[i] = aos[i].z;
+        }
+    }
+    template <typename E>
+    vector3DArray(const __ArrayExpression<E, 3> &expr) : vector3DArray(expr.size()) {
+        __assign(static_cast<const E&>(expr));
+    }
+    inline void resize(const std::size_t size) {
+        vector3DArray tmp(size);
+        const std::size_t m = std::min(size, n);
+        std::copy(x(), x() + m, tmp.x());
+        std::copy(y(), y() + m, tmp.y());
+        std::copy(z(), z() + m, tmp.z());
+        swap(tmp);
+    }
+    inline void swap(vector3DArray &other) noexcept {
+        data.swap(other.data);
+        std::swap(n, other.n);
+        std::swap(stride, other.stride);
+    }
+    inline std::vector<vector3D<T>> to_vector() const {
+        std::vector<vector3D<T>> aos(n);
+        for (std::size_t i = 0; i < n; ++i)
+            aos[i].load(x()[i], y()[i], z()[i]);
+        return aos;
+    }
+
+    // Component arrays
+    inline T* x() noexcept { return data.data(); }
+    inline T* y() noexcept { return data.data() + stride; }
+    inline T* z() noexcept { return data.data() + 2 * stride; }
+    inline const T* x() const noexcept { return data.data(); }
+    inline const T* y() const noexcept { return data.data() + stride; }
+    inline const T* z() const noexcept { return data.data() + 2 * stride; }
+
+    inline vector3D<T> operator[](const std::size_t i) const noexcept {
+        return vector3D<T>(x()[i], y()[i], z()[i]);
+    }
+    inline __Vec3DRef<T> operator[](const std::size_t i) noexcept {
+        return __Vec3DRef<T>(x()[i], y()[i], z()[i]);
+    }
+    inline vector3D<T> at(const std::size_t i) const {
+        if (i >= n) throw std::out_of_range("vector3DArray: Index out of range");
+        return (*this)[i];
+    }
+    inline __Vec3DRef<T> at(const std::size_t i) {
+        if (i >= n) throw std::out_of_range("vector3DArray: Index out of range");
+        return (*this)[i];
+    }
+    /*
+    *  OPERATORS
+    */
+    template <typename E>
+    inline vector3DArray& operator=(const __ArrayExpression<E, 3> &expr) {
+        const E& e = static_cast<const E&>(expr);
+        if (e.size() != n) {
+            vector3DArray tmp(e.size());
+            tmp.__assign(e);
+            swap(tmp);
+        }
+        else __assign(e);
+        return *this;
+    }
+    template <typename E>
+    inline vector3DArray& operator+=(const __ArrayExpression<E, 3> &expr) {
+        if (expr.size() != n) throw std::length_error("vector3DArray: Size mismatch");
+        __assign(*this + expr);
+        return *this;
+    }
+    template <typename E>
+    inline vector3DArray& operator-=(const __ArrayExpression<E, 3> &expr) {
+        if (expr.size() != n) throw std::length_error("vector3DArray: Size mismatch");
+        __assign(*this - expr);
+        return *this;
+    }
+    template <__Number E>
+    inline vector3DArray& operator*=(const E &a) noexcept {
+        __assign(*this * a);
+        return *this;
+    }
+    template <__Number E>
+    inline vector3DArray& operator/=(const E &a) noexcept {
+        __assign(*this / a);
+        return *this;
+    }
+};
+
+/*
+*  Arrays of structs in array expressions.
+*  vectorArrayRef refers to the vectors of a std::vector<vector3D>, vector2D or vectorND (or any
+*  contiguous array of them) without copying them or changing their layout, and aos() makes one:
+*      aos(A) = aos(B) + s * aos(C);
+*  evaluates the whole right hand side in one pass over the arrays, as for vector3DArray. The reference
+*  can't resize the array, so the sizes must match.
+*/
+template <typename V>
+class vectorArrayRef : public __ArrayExpression<vectorArrayRef<V>, std::remove_const_t<V>::size()> {
+    V* _data = nullptr;
+    std::size_t _n = 0;
+
+    template <typename E>
+    inline void __assign(const E &expr) const noexcept {
+        __VECTOR3D_IVDEP
+        for (std::size_t i = 0; i < _n; ++i)
+            _data[i] = expr[i];
+    }
+public:
+    constexpr vectorArrayRef() noexcept = default;
+    constexpr vectorArrayRef(V *data, const std::size_t size) noexcept : _data(data), _n(size) {}
+    constexpr vectorArrayRef(const vectorArrayRef&) noexcept = default;
+
+    inline constexpr std::size_t size() const noexcept {
+        return _n;
+    }
+    inline constexpr V* data() const noexcept {
+        return _data;
+    }
+    inline constexpr V& operator[](const std::size_t i) const noexcept {
+        return _data[i];
+    }
+    inline V& at(const std::size_t i) const {
+        if (i >= _n) throw std::out_of_range("vectorArrayRef: Index out of range");
+        return _data[i];
+    }
+    /*
+    *  OPERATORS
+    *  They write through the reference, so they are const like the ones of a pointer.
+    */
+    inline const vectorArrayRef& operator=(const vectorArrayRef &other) const requires (!std::is_const_v<V>) {
+        return *this = static_cast<const __ArrayExpression<vectorArrayRef, V::size()>&>(other);
+    }
+    template <typename E>
+    inline const vectorArrayRef& operator=(const __ArrayExpression<E, V::size()> &expr) const requires (!std::is_const_v<V>) {
+        if (expr.size() != _n) throw std::length_error("vectorArrayRef: Size mismatch");
+        __assign(static_cast<const E&>(expr));
+        return *this;
+    }
+    template <typename E>
+    inline const vectorArrayRef& operator+=(const __ArrayExpression<E, V::size()> &expr) const requires (!std::is_const_v<V>) {
+        if (expr.size() != _n) throw std::length_error("vectorArrayRef: Size mismatch");
+        __assign(*this + expr);
+        return *this;
+    }
+    template <typename E>
+    inline const vectorArrayRef& operator-=(const __ArrayExpression<E, V::size()> &expr) const requires (!std::is_const_v<V>) {
+        if (expr.size() != _n) throw std::length_error("vectorArrayRef: Size mismatch");
+        __assign(*this - expr);
+        return *this;
+    }
+    template <__Number E>
+    inline const vectorArrayRef& operator*=(const E &a) const noexcept requires (!std::is_const_v<V>) {
+        __assign(*this * a);
+        return *this;
+    }
+    template <__Number E>
+    inline const vectorArrayRef& operator/=(const E &a) const noexcept requires (!std::is_const_v<V>) {
+        __assign(*this / a);
+        return *this;
+    }
+};
+template <typename V, typename A>
+inline vectorArrayRef<V> aos(std::vector<V, A> &v) noexcept {
+    return vectorArrayRef<V>(v.data(), v.size());
+}
+template <typename V, typename A>
+inline vectorArrayRef<const V> aos(const std::vector<V, A> &v) noexcept {
+    return vectorArrayRef<const V>(v.data(), v.size());
+}
+
+/*
+*  Fused assignments.
+*  assign(dest, expr) records an assignment without evaluating it, and fuse() evaluates several of them
+*  in a single pass over the elements: for every i, the first assignment, then the second one, and so on.
+*  A later expression can read an array written by an earlier one, and sees the new values, as if the
+*  assignments ran one after the other:
+*      fuse(assign(aos(A), aos(B) + s * aos(C)), assign(aos(E), unit(aos(A))));
+*  reads B and C and writes A and E once, where two loops would read A again. Every expression must read
+*  only element i of the arrays for element i, which is the case of all the array expressions.
+*/
+template <typename D, typename E>
+class __ArrayAssignment {
+    D _dest;            // by value for an rvalue (vectorArrayRef), by reference for an lvalue
+    const E& _expr;
+public:
+    constexpr __ArrayAssignment(D &&dest, const E &expr) noexcept : _dest(std::forward<D>(dest)), _expr(expr) {}
+    inline constexpr std::size_t size() const {
+        return _expr.size();
+    }
+    inline constexpr std::size_t __dest_size() const {
+        return _dest.size();
+    }
+    inline constexpr void __step(const std::size_t i) {
+        _dest[i] = _expr[i];
+    }
+};
+template <typename D, typename E, std::size_t N>
+inline constexpr __ArrayAssignment<D, E> assign(D &&dest, const __ArrayExpression<E, N> &expr) noexcept {
+    return __ArrayAssignment<D, E>(std::forward<D>(dest), static_cast<const E&>(expr));
+}
+template <typename... D, typename... E>
+inline void fuse(__ArrayAssignment<D, E>&&... assignments) {
+    const std::size_t n = (assignments.size(), ...);
+    if (((assignments.size() != n || assignments.__dest_size() != n) || ...))
+        throw std::length_error("fuse: Size mismatch");
+    for (std::size_t i = 0; i < n; ++i)
+        (assignments.__step(i), ...);
+}
@@ -0,0 +1,366 @@
+#pragma once
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include "vector_array.h"
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define __VECTOR3D_MMAP 1
+#endif
+
+/*
+ * This file is part of the Vector3D distribution (https://github.com/cdelv/Vector3D).
+ * Copyright (c) 2022 Carlos Andres del Valle.
+ *
+ * Vector3D is under the terms of the BSD-3 license. We welcome feedback and contributions.
+ *
+ * you should have received a copy of the BSD3 Public License
+ * along with this program. If not, see <https://github.com/cdelv/Vector3D> LICENSE.
+ *
+ *
+ * This library requires C++20.
+*/
+
+/*
+*  Binary files of vector arrays.
+*  A 64 byte header records the format version, the byte order, the component type, the dimension, the
+*  number of vectors, and the layout. The data follows at a 64 byte aligned offset, either as an array
+*  of vectors (AoS, the bytes of std::vector<vector3D<T>>) or as one array per component (SoA, like
+*  vector3DArray), each starting on a cache line. Since the data is stored as it is in memory, a reader
+*  maps the file and uses it in place: loading is paging, not parsing.
+*/
+enum class vector_layout : std::uint8_t { aos = 0, soa = 1 };
+
+struct __VectorFileHeader {
+    char magic[8];              // "VECTOR3D"
+    std::uint32_t version;
+    std::uint32_t byte_order;   // __byte_order as the writer stored it
+    std::uint8_t scalar;        // __scalar_code of the components
+    std::uint8_t scalar_bytes;
+    std::uint8_t layout;        // vector_layout
+    std::uint8_t reserved0;
+    std::uint32_t dimension;
+    std::uint64_t count;        // number of vectors
+    std::uint64_t stride;       // AoS: bytes per vector. SoA: components per array, padded to a cache line
+    std::uint64_t data_offset;  // from the start of the file
+    std::uint8_t reserved[16];
+};
+static_assert(sizeof(__VectorFileHeader) == 64 && std::is_trivially_copyable_v<__VectorFileHeader>);
+
+inline constexpr char __vector_file_magic[8] = {'V', 'E', 'C', 'T', 'O', 'R', '3', 'D'};
+inline constexpr std::uint32_t __vector_file_version = 1;
+// Reads as 0x04030201 on a machine with the opposite byte order
+inline constexpr std::uint32_t __byte_order = 0x01020304;
+
+// Component types that can be stored, 0 for the rest
+template <typename T>
+inline constexpr std::uint8_t __scalar_code = std::is_same_v<T, float> ? 1
+                                            : std::is_same_v<T, double> ? 2
+                                            : std::is_same_v<T, std::complex<float>> ? 3
+                                            : std::is_same_v<T, std::complex<double>> ? 4
+                                            : std::is_same_v<T, std::int32_t> ? 5
+                                            : std::is_same_v<T, std::int64_t> ? 6 : 0;
+inline const char* __scalar_name(const std::uint8_t code) {
+    static constexpr const char* names[] = {"unknown", "float", "double", "complex<float>", "complex<double>", "int32", "int64"};
+    return names[code < 7 ? code : 0];
+}
+inline constexpr std::uint8_t __scalar_bytes(const std::uint8_t code) noexcept {
+    constexpr std::uint8_t bytes[] = {0, sizeof(float), sizeof(double), sizeof(std::complex<float>), sizeof(std::complex<double>), 4, 8};
+    return code < 7 ? bytes[code] : 0;
+}
+
+// Components and dimension of the vector types
+template <typename V>
+using __component_t = std::remove_cvref_t<decltype(std::declval<const V&>()[0])>;
+template <typename T, std::size_t N>
+using __vector_t = std::conditional_t<N == 3, vector3D<T>, std::conditional_t<N == 2, vector2D<T>, vectorND<T, N>>>;
+
+// Components per array in the SoA layout: padded to a whole cache line, like vector3DArray
+template <typename T>
+inline constexpr std::uint64_t __soa_stride(const std::uint64_t count) noexcept {
+    constexpr std::uint64_t lane = 64 / sizeof(T) > 0 ? 64 / sizeof(T) : 1;
+    return (count + lane - 1) / lane * lane;
+}
+template <typename T, std::size_t N>
+inline __VectorFileHeader __make_header(const std::uint64_t count, const vector_layout layout) {
+    static_assert(__scalar_code<T> != 0, "vector file: unsupported component type");
+    __VectorFileHeader h{};
+    std::memcpy(h.magic, __vector_file_magic, sizeof(h.magic));
+    h.version = __vector_file_version;
+    h.byte_order = __byte_order;
+    h.scalar = __scalar_code<T>;
+    h.scalar_bytes = sizeof(T);
+    h.layout = static_cast<std::uint8_t>(layout);
+    h.dimension = N;
+    h.count = count;
+    h.stride = layout == vector_layout::aos ? sizeof(__vector_t<T, N>) : __soa_stride<T>(count);
+    h.data_offset = sizeof(__VectorFileHeader);
+    return h;
+}
+
+// Streams the header and the data to a file. The data goes out in blocks of a few MiB.
+class __VectorFileWriter {
+    std::ofstream _file;
+    std::string _path;
+    std::uint64_t _written = 0;
+public:
+    explicit __VectorFileWriter(const std::string &path) : _file(path, std::ios::binary | std::ios::trunc), _path(path) {
+        if (!_file)
+            throw std::runtime_error("vector file: cannot open " + path);
+    }
+    inline void write(const void *data, const std::size_t bytes) {
+        _file.write(static_cast<const char*>(data), static_cast<std::streamsize>(bytes));
+        if (!_file)
+            throw std::runtime_error("vector file: cannot write " + _path);
+        _written += bytes;
+    }
+    // Zeros up to the next multiple of align
+    inline void pad(const std::size_t align) {
+        static constexpr char zeros[64] = {};
+        write(zeros, (align - _written % align) % align);
+    }
+    inline void close() {
+        _file.close();
+        if (!_file)
+            throw std::runtime_error("vector file: cannot write " + _path);
+    }
+};
+// One array per component, gathered from any indexable sequence of vectors
+template <typename T, std::size_t N, typename Get>
+inline void __write_soa(__VectorFileWriter &out, const std::uint64_t count, Get &&get) {
+    constexpr std::size_t block = (4 << 20) / sizeof(T);
+    std::vector<T> buffer(std::min<std::size_t>(block, count));
+    for (std::size_t k = 0; k < N; ++k) {
+        for (std::uint64_t start = 0; start < count; start += block) {
+            const std::size_t m = std::min<std::uint64_t>(block, count - start);
+            for (std::size_t i = 0; i < m; ++i)
+                buffer[i] = get(start + i, k);
+            out.write(buffer.data(), m * sizeof(T));
+        }
+        out.pad(64);
+    }
+}
+
+// Writes vectors (vector2D, vector3D or vectorND) in either layout
+template <typename V>
+inline void write_vectors(const std::string &path, const std::vector<V> &vectors, const vector_layout layout = vector_layout::aos) {
+    using T = __component_t<V>;
+    constexpr std::size_t N = V::size();
+    static_assert(std::is_same_v<V, __vector_t<T, N>> && std::is_trivially_copyable_v<V>);
+    const __VectorFileHeader h = __make_header<T, N>(vectors.size(), layout);
+    __VectorFileWriter out(path);
+    out.write(&h, sizeof(h));
+    if (layout == vector_layout::aos)
+        out.write(vectors.data(), vectors.size() * sizeof(V));
+    else
+        __write_soa<T, N>(out, vectors.size(), [&](const std::size_t i, const std::size_t k) { return vectors[i][k]; });
+    out.close();
+}
+template <typename T>
+inline void write_vectors(const std::string &path, const vector3DArray<T> &vectors, const vector_layout layout = vector_layout::soa) {
+    const __VectorFileHeader h = __make_header<T, 3>(vectors.size(), layout);
+    __VectorFileWriter out(path);
+    out.write(&h, sizeof(h));
+    if (layout == vector_layout::soa) {
+        for (const T* c : {vectors.x(), vectors.y(), vectors.z()}) {
+            out.write(c, vectors.size() * sizeof(T));
+            out.pad(64);
+        }
+    }
+    else {
+        constexpr std::size_t block = (4 << 20) / sizeof(vector3D<T>);
+        std::vector<vector3D<T>> buffer(std::min<std::size_t>(block, vectors.size()));
+        for (std::size_t start = 0; start < vectors.size(); start += block) {
+            const std::size_t m = std::min(block, vectors.size() - start);
+            for (std::size_t i = 0; i < m; ++i)
+                buffer[i] = vectors[start + i];
+            out.write(buffer.data(), m * sizeof(vector3D<T>));
+        }
+    }
+    out.close();
+}
+
+/*
+*  Zero-copy view of the SoA layout. It is an array expression, so it can be used with the operators
+*  of vector_array.h and to build a vector3DArray. operator[](i) returns the i-th vector by value.
+*/
+template <__Number T, std::size_t N>
+class vectorArrayView : public __ArrayExpression<vectorArrayView<T, N>, N> {
+    const T* _data = nullptr;
+    std::size_t _n = 0;
+    std::size_t _stride = 0;
+public:
+    constexpr vectorArrayView() noexcept = default;
+    constexpr vectorArrayView(const T *data, const std::size_t size, const std::size_t stride) noexcept : _data(data), _n(size), _stride(stride) {}
+
+    inline constexpr std::size_t size() const noexcept {
+        return _n;
+    }
+    // Array of component k
+    inline constexpr const T* component(const std::size_t k) const noexcept {
+        return _data + k * _stride;
+    }
+    inline constexpr const T* x() const noexcept requires (N <= 3) { return component(0); }
+    inline constexpr const T* y() const noexcept requires (N <= 3) { return component(1); }
+    inline constexpr const T* z() const noexcept requires (N == 3) { return component(2); }
+
+    inline constexpr __vector_t<T, N> operator[](const std::size_t i) const noexcept {
+        __vector_t<T, N> v;
+        for (std::size_t k = 0; k < N; ++k)
+            v[k] = _data[k * _stride + i];
+        return v;
+    }
+    inline __vector_t<T, N> at(const std::size_t i) const {
+        if (i >= _n) throw std::out_of_range("vectorArrayView: Index out of range");
+        return (*this)[i];
+    }
+};
+
+/*
+*  A vector file mapped into memory. The views it returns point into the mapping, so they are valid
+*  while the vector_file lives. Files written on a machine with the other byte order are rejected.
+*  Without mmap (not POSIX), the file is read into memory instead.
+*/
+class vector_file {
+    const std::byte* _data = nullptr;
+    std::size_t _bytes = 0;
+    __VectorFileHeader _header{};
+#if !defined(__VECTOR3D_MMAP)
+    std::vector<std::byte, __AlignedAllocator<std::byte>> _buffer;
+#endif
+
+    inline void __unmap() noexcept {
+#if defined(__VECTOR3D_MMAP)
+        if (_data) munmap(const_cast<std::byte*>(_data), _bytes);
+#endif
+        _data = nullptr;
+        _bytes = 0;
+    }
+    inline void __validate(const std::string &path) {
+        const auto fail = [&](const std::string &why) {
+            __unmap();
+            throw std::runtime_error("vector file: " + path + ": " + why);
+        };
+        if (_bytes < sizeof(__VectorFileHeader))
+            fail("too short");
+        std::memcpy(&_header, _data, sizeof(_header));
+        if (std::memcmp(_header.magic, __vector_file_magic, sizeof(_header.magic)) != 0)
+            fail("not a vector file");
+        if (_header.byte_order != __byte_order)
+            fail("written with the other byte order");
+        if (_header.version != __vector_file_version)
+            fail("unsupported version " + std::to_string(_header.version));
+        // The sizes below are computed from scalar_bytes, so it has to agree with the type
+        if (_header.layout > 1 || _header.dimension == 0 || _header.scalar_bytes == 0 || _header.scalar_bytes != __scalar_bytes(_header.scalar) || (_header.stride == 0 && _header.count > 0)
+            || _header.data_offset % 64 != 0 || _header.data_offset < sizeof(__VectorFileHeader))
+            fail("corrupt header");
+        // Compared by division, a corrupt header could overflow the products
+        const std::uint64_t available = _bytes > _header.data_offset ? _bytes - _header.data_offset : 0;
+        bool truncated = false;
+        if (_header.count > 0 && _header.layout == static_cast<std::uint8_t>(vector_layout::aos))
+            truncated = _header.count > available / _header.stride;
+        else if (_header.count > 0)
+            truncated = _header.stride < _header.count || _header.stride > available / _header.scalar_bytes
+                        || _header.dimension > available / (_header.stride * _header.scalar_bytes);
+        if (truncated)
+            fail("truncated, " + std::to_string(_bytes) + " bytes");
+    }
+    template <typename T, std::size_t N>
+    inline void __check(const vector_layout layout) const {
+        if (_header.scalar != __scalar_code<T> || _header.scalar_bytes != sizeof(T) || _header.dimension != N)
+            throw std::runtime_error(std::string("vector file: holds ") + std::to_string(_header.dimension) + "D vectors of "
+                                     + __scalar_name(_header.scalar) + ", not " + std::to_string(N) + "D of " + __scalar_name(__scalar_code<T>));
+        if (_header.layout != static_cast<std::uint8_t>(layout))
+            throw std::runtime_error(std::string("vector file: the layout is ") + (_header.layout ? "SoA" : "AoS"));
+    }
+public:
+    explicit vector_file(const std::string &path) {
+#if defined(__VECTOR3D_MMAP)
+        const int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0)
+            throw std::runtime_error("vector file: cannot open " + path);
+        struct stat st;
+        if (fstat(fd, &st) != 0) {
+            ::close(fd);
+            throw std::runtime_error("vector file: cannot open " + path);
+        }
+        _bytes = static_cast<std::size_t>(st.st_size);
+        void* p = _bytes ? mmap(nullptr, _bytes, PROT_READ, MAP_PRIVATE, fd, 0) : MAP_FAILED;
+        ::close(fd);
+        if (p == MAP_FAILED) {
+            _bytes = 0;
+            throw std::runtime_error("vector file: cannot map " + path);
+        }
+        _data = static_cast<const std::byte*>(p);
+#else
+        std::ifstream file(path, std::ios::binary | std::ios::ate);
+        if (!file)
+            throw std::runtime_error("vector file: cannot open " + path);
+        _buffer.resize(static_cast<std::size_t>(file.tellg()));
+        file.seekg(0);
+        file.read(reinterpret_cast<char*>(_buffer.data()), static_cast<std::streamsize>(_buffer.size()));
+        _data = _buffer.data();
+        _bytes = _buffer.size();
+#endif
+        __validate(path);
+    }
+    vector_file(const vector_file&) = delete;
+    vector_file& operator=(const vector_file&) = delete;
+    vector_file(vector_file &&other) noexcept
+        : _data(std::exchange(other._data, nullptr)), _bytes(std::exchange(other._bytes, 0)), _header(other._header)
+#if !defined(__VECTOR3D_MMAP)
+        , _buffer(std::move(other._buffer))
+#endif
+    {}
+    vector_file& operator=(vector_file &&other) noexcept {
+        if (this != &other) {
+            __unmap();
+            _data = std::exchange(other._data, nullptr);
+            _bytes = std::exchange(other._bytes, 0);
+            _header = other._header;
+#if !defined(__VECTOR3D_MMAP)
+            _buffer = std::move(other._buffer);
+#endif
+        }
+        return *this;
+    }
+    ~vector_file() {
+        __unmap();
+    }
+
+    inline std::size_t size() const noexcept {
+        return _header.count;
+    }
+    inline std::size_t dimension() const noexcept {
+        return _header.dimension;
+    }
+    inline vector_layout layout() const noexcept {
+        return static_cast<vector_layout>(_header.layout);
+    }
+    inline const __VectorFileHeader& header() const noexcept {
+        return _header;
+    }
+
+    // The vectors of an AoS file, V being the vector2D, vector3D or vectorND it was written from
+    template <typename V>
+    inline std::span<const V> aos() const {
+        using T = __component_t<V>;
+        __check<T, V::size()>(vector_layout::aos);
+        if (_header.stride != sizeof(V))
+            throw std::runtime_error("vector file: vectors of " + std::to_string(_header.stride) + " bytes, not " + std::to_string(sizeof(V)));
+        return std::span<const V>(reinterpret_cast<const V*>(_data + _header.data_offset), _header.count);
+    }
+    // The component arrays of an SoA file
+    template <typename T, std::size_t N>
+    inline vectorArrayView<T, N> soa() const {
+        __check<T, N>(vector_layout::soa);
+        return vectorArrayView<T, N>(reinterpret_cast<const T*>(_data + _header.data_offset), _header.count, _header.stride);
+    }
+};
@@ -0,0 +1,134 @@
+#pragma once
+#include <bit>
+#include <limits>
+#include <cstdint>
+#include "vector.h"
+#if defined(__SSE__) || defined(_M_X64)
+#include <immintrin.h>
+#endif
+
+/*
+ * This file is part of the Vector3D distribution (https://github.com/cdelv/Vector3D).
+ * Copyright (c) 2022 Carlos Andres del Valle.
+ *
+ * Vector3D is under the terms of the BSD-3 license. We welcome feedback and contributions.
+ *
+ * you should have received a copy of the BSD3 Public License
+ * along with this program. If not, see <https://github.com/cdelv/Vector3D> LICENSE.
+ *
+ *
+ * This library requires C++20.
+*/
+
+/*
+*  Approximate math policy. The functions in namespace fastmath replace divisions by multiplications
+*  by a reciprocal and use a hardware reciprocal square root refined with Newton steps. Each one
+*  documents its worst error in ulp (units in the last place of the result), measured against the
+*  correctly rounded value over the inputs listed, so the accuracy given away is known at every call.
+*  They are defined for float and double components.
+*/
+namespace fastmath {
+
+// 1/sqrt(x). Worst error: 4 ulp for float over all positive normal x, 3 ulp for double over the normal
+// range of float. Other arguments, including doubles outside that range, fall back to 1/std::sqrt(x).
+template <std::floating_point T>
+inline constexpr T rsqrt(const T x) noexcept {
+    if constexpr (std::is_same_v<T, long double>)
+        return T(1) / std::sqrt(x);
+    else {
+        if (std::is_constant_evaluated() || !(x >= std::numeric_limits<float>::min() && x <= std::numeric_limits<float>::max()))
+            return T(1) / std::sqrt(x);
+        // Seed with about 12 correct bits, or 9 from the bit trick elsewhere
+#if defined(__SSE__) || defined(_M_X64)
+        T y = _mm_cvtss_f32(_mm_rsqrt_ss(_mm_set_ss(static_cast<float>(x))));
+        constexpr int Steps = std::is_same_v<T, float> ? 1 : 3;
+#else
+        T y = std::bit_cast<float>(0x5f375a86u - (std::bit_cast<std::uint32_t>(static_cast<float>(x)) >> 1));
+        constexpr int Steps = std::is_same_v<T, float> ? 2 : 4;
+#endif
+        // Each Newton step doubles the correct bits: y (3 - x y^2) / 2. x y is about sqrt(x), so no product
+        // leaves the normal range, where x / 2 would be subnormal for float x near the smallest normal.
+        for (int i = 0; i < Steps; ++i)
+            y = y * (T(1.5) - T(0.5) * (x * y) * y);
+        return y;
+    }
+}
+// acos(x) for x in [-1, 1], Abramowitz and Stegun 4.4.46. Arguments outside are clamped.
+// Worst error: 3 ulp for float. For double it is not bounded in ulp: the polynomial only has float
+// accuracy, 2.2e-8 absolute, which is up to 1.4e8 ulp of a double near x = 1.
+template <std::floating_point T>
+inline constexpr T acos(const T x) noexcept {
+    const T a = std::min(std::abs(x), T(1));
+    T p = T(-0.0012624911);
+    p = p * a + T(0.0066700901);
+    p = p * a + T(-0.0170881256);
+    p = p * a + T(0.0308918810);
+    p = p * a + T(-0.0501743046);
+    p = p * a + T(0.0889789874);
+    p = p * a + T(-0.2145988016);
+    p = p * a + T(1.5707963050);
+    const T r = std::sqrt(T(1) - a) * p;
+    return x < 0 ? T(M_PI) - r : r;
+}
+
+// Reciprocal scaling: components of u times 1/Norm, computed once
+template <typename E1, typename E2, std::size_t N>
+class __VecReciprocalScaling : public __VecExpression<__VecReciprocalScaling<E1, E2, N>, N> {
+    // u is read by the norm and again by every component
+    __operand_t<E1, 2> _u;
+    const E2 Inv;
+public:
+    static constexpr std::size_t __cost = __cost_v<std::remove_cvref_t<decltype(_u)>> + 1;
+    constexpr __VecReciprocalScaling(const E1 &u) noexcept : _u(u), Inv(rsqrt(::norm2(_u))) {};
+    inline constexpr const auto operator[](const std::size_t i) const {
+        return _u[i] * Inv;
+    }
+    template <std::size_t I>
+    inline constexpr const auto get() const noexcept {
+        return _u.template get<I>() * Inv;
+    }
+    inline constexpr auto __factors(const std::size_t i) const {
+        return std::pair(_u[i], Inv);
+    }
+    template <std::size_t I>
+    inline constexpr auto __factors() const noexcept {
+        return std::pair(_u.template get<I>(), Inv);
+    }
+    static inline constexpr const std::size_t size() {
+        return N;
+    }
+};
+// 1/|u|. Worst error: that of rsqrt plus the rounding of norm2.
+template <typename E1, std::size_t N>
+inline constexpr auto rnorm(const __VecExpression<E1, N> &u) noexcept {
+    return rsqrt(::norm2(u));
+}
+// u/|u| as u * rsqrt(norm2(u)). Worst error per component: 6 ulp for float, 4 ulp for double.
+template <typename E1, std::size_t N>
+inline constexpr auto unit(const __VecExpression<E1, N> &u) noexcept {
+    return __VecReciprocalScaling<E1, decltype(rnorm(u)), N>(*static_cast<const E1*>(&u));
+}
+// In place version of unit, the counterpart of v.unit()
+template <typename V>
+inline constexpr V& normalize(V &v) noexcept {
+    v *= rnorm(v);
+    return v;
+}
+// u/a as u * (1/a). Worst error per component: 1.5 ulp.
+template <typename E1, std::floating_point E2, std::size_t N>
+inline constexpr auto div(const __VecExpression<E1, N> &u, const E2 &a) noexcept {
+    return u * (E2(1) / a);
+}
+// Angle between 2 vectors with the reciprocal norms and the polynomial acos. The cosine is clamped
+// to [-1, 1], so parallel vectors give 0 or pi instead of NaN. The error adds the one of acos to
+// a few ulp of the cosine. Near 0 and pi the rounding of the cosine dominates, as it does for angle().
+template <typename E1, typename E2, std::size_t N>
+inline constexpr auto angle(const __VecExpression<E1, N> &u, const __VecExpression<E2, N> &v) noexcept {
+    return fastmath::acos(dot(u, v) * rnorm(u) * rnorm(v));
+}
+template <typename E1, typename E2, std::size_t N>
+inline constexpr auto angled(const __VecExpression<E1, N> &u, const __VecExpression<E2, N> &v) noexcept {
+    return __radians_to_degrees(fastmath::angle(u, v));
+}
+
+}
@@ -0,0 +1,301 @@
+#pragma once
+#include <bit>
+#include <cstdint>
+#include <type_traits>
+#include "vector_simd.h"
+
+/*
+ * This file is part of the Vector3D distribution (https://github.com/cdelv/Vector3D).
+ * Copyright (c) 2022 Carlos Andres del Valle.
+ *
+ * Vector3D is under the terms of the BSD-3 license. We welcome feedback and contributions.
+ *
+ * you should have received a copy of the BSD3 Public License
+ * along with this program. If not, see <https://github.com/cdelv/Vector3D> LICENSE.
+ *
+ *
+ * This library requires C++20.
+*/
+
+/*
+*  16 bit floating point components
+*  float16 (IEEE binary16: 5 exponent bits, 10 mantissa bits) and bfloat16 (8 exponent bits, 7 mantissa
+*  bits, the range of float) are storage types: they convert to float, and every operation on them is a
+*  float operation. So an expression over vector3D<float16> evaluates in float, norm() and dot() of them
+*  accumulate in float, and only storing a result back into a vector of float16 rounds it to 16 bits.
+*  Conversions round to nearest even, from double and the integer types directly. The batch_convert kernels convert whole arrays with F16C or
+*  AVX-512 when the CPU has them, with the same results as the scalar conversions.
+*/
+// float to binary16, round to nearest even. NaNs stay NaN, quiet.
+inline constexpr std::uint16_t __float_to_half(const float f) noexcept {
+    const std::uint32_t x = std::bit_cast<std::uint32_t>(f);
+    const std::uint32_t sign = (x >> 16) & 0x8000;
+    std::uint32_t a = x & 0x7fffffff;
+    if (a > 0x7f800000)                                     // NaN
+        return static_cast<std::uint16_t>(sign | 0x7e00 | ((a >> 13) & 0x3ff));
+    if (a >= 0x477ff000)                                    // from 65520 up, infinity
+        return static_cast<std::uint16_t>(sign | 0x7c00);
+    if (a < 0x38800000) {                                   // below 2^-14, subnormal: the float addition rounds at 2^-24
+        const float t = std::bit_cast<float>(a) + 0.5f;
+        return static_cast<std::uint16_t>(sign | (std::bit_cast<std::uint32_t>(t) - 0x3f000000));
+    }
+    a += 0xc8000fff + ((a >> 13) & 1);                      // exponent bias 127 to 15, and rounding
+    return static_cast<std::uint16_t>(sign | (a >> 13));
+}
+inline constexpr float __half_to_float(const std::uint16_t h) noexcept {
+    const std::uint32_t sign = static_cast<std::uint32_t>(h & 0x8000) << 16;
+    const std::uint32_t e = (h >> 10) & 0x1f, m = h & 0x3ff;
+    if (e == 0x1f)
+        return std::bit_cast<float>(sign | 0x7f800000 | (m << 13));
+    if (e == 0) {
+        const float v = static_cast<float>(m) * 0x1p-24f;
+        return sign ? -v : v;
+    }
+    return std::bit_cast<float>(sign | ((e + 112) << 23) | (m << 13));
+}
+// float to bfloat16: the upper half of the bits, round to nearest even
+inline constexpr std::uint16_t __float_to_bfloat(const float f) noexcept {
+    const std::uint32_t x = std::bit_cast<std::uint32_t>(f);
+    if ((x & 0x7fffffff) > 0x7f800000)
+        return static_cast<std::uint16_t>((x >> 16) | 0x40);
+    return static_cast<std::uint16_t>((x + 0x7fff + ((x >> 16) & 1)) >> 16);
+}
+inline constexpr float __bfloat_to_float(const std::uint16_t b) noexcept {
+    return std::bit_cast<float>(static_cast<std::uint32_t>(b) << 16);
+}
+
+// x as a float rounded to odd: toward zero, with the last bit set if that was inexact. Rounding it again
+// to 16 bits, to nearest even, gives the correctly rounded value since float keeps more than two extra bits.
+// Going through a float rounded to nearest would round twice, e.g. 1 + 2^-11 + 2^-40 to 1 instead of 1 + 2^-10.
+template <typename U> requires std::is_arithmetic_v<U>
+inline constexpr float __to_float_odd(const U x) noexcept {
+    if constexpr (std::is_integral_v<U>) {
+        // Keep the leading 24 bits of the magnitude and fold the rest into the last one
+        const bool negative = x < U(0);
+        std::uint64_t m = negative ? 0 - static_cast<std::uint64_t>(x) : static_cast<std::uint64_t>(x);
+        const int s = std::bit_width(m) > 24 ? std::bit_width(m) - 24 : 0;
+        if (s > 0) m = (m >> s) | ((m & ((std::uint64_t(1) << s) - 1)) != 0);
+        const float f = static_cast<float>(m) * static_cast<float>(std::uint64_t(1) << s);
+        return negative ? -f : f;
+    }
+    else {
+        const float f = static_cast<float>(x);
+        if (static_cast<U>(f) == x || x != x) return f;
+        std::uint32_t b = std::bit_cast<std::uint32_t>(f);
+        if ((f < 0 ? -static_cast<U>(f) : static_cast<U>(f)) > (x < 0 ? -x : x)) --b;  // rounded away from zero
+        return std::bit_cast<float>(b | 1);
+    }
+}
+// The two types differ only in the conversions
+template <std::uint16_t (*Encode)(float), float (*Decode)(std::uint16_t)>
+class __float16_base {
+    std::uint16_t _bits = 0;
+public:
+    constexpr __float16_base() noexcept = default;
+    constexpr __float16_base(const float x) noexcept : _bits(Encode(x)) {}
+    template <typename U> requires std::is_arithmetic_v<U>
+    constexpr __float16_base(const U x) noexcept : _bits(Encode(__to_float_odd(x))) {}
+    constexpr operator float() const noexcept {
+        return Decode(_bits);
+    }
+    static constexpr __float16_base from_bits(const std::uint16_t bits) noexcept {
+        __float16_base h;
+        h._bits = bits;
+        return h;
+    }
+    constexpr std::uint16_t bits() const noexcept {
+        return _bits;
+    }
+    template <typename U>
+    constexpr __float16_base& operator+=(const U &a) noexcept { return *this = float(*this) + a; }
+    template <typename U>
+    constexpr __float16_base& operator-=(const U &a) noexcept { return *this = float(*this) - a; }
+    template <typename U>
+    constexpr __float16_base& operator*=(const U &a) noexcept { return *this = float(*this) * a; }
+    template <typename U>
+    constexpr __float16_base& operator/=(const U &a) noexcept { return *this = float(*this) / a; }
+};
+using float16 = __float16_base<__float_to_half, __half_to_float>;
+using bfloat16 = __float16_base<__float_to_bfloat, __bfloat_to_float>;
+static_assert(sizeof(float16) == 2 && sizeof(bfloat16) == 2 && std::is_trivially_copyable_v<float16>);
+
+template <>
+struct is_half_float<float16> : std::true_type {};
+template <>
+struct is_half_float<bfloat16> : std::true_type {};
+
+/*
+*  Batch conversion kernels. The 16 bit values are passed as their bits.
+*/
+namespace __isa_scalar {
+inline void __half_to_float_n(const std::uint16_t* in, float* out, const std::size_t n) noexcept {
+    for (std::size_t i = 0; i < n; ++i) out[i] = __half_to_float(in[i]);
+}
+inline void __float_to_half_n(const float* in, std::uint16_t* out, const std::size_t n) noexcept {
+    for (std::size_t i = 0; i < n; ++i) out[i] = __float_to_half(in[i]);
+}
+inline void __bfloat_to_float_n(const std::uint16_t* in, float* out, const std::size_t n) noexcept {
+    for (std::size_t i = 0; i < n; ++i) out[i] = __bfloat_to_float(in[i]);
+}
+inline void __float_to_bfloat_n(const float* in, std::uint16_t* out, const std::size_t n) noexcept {
+    for (std::size_t i = 0; i < n; ++i) out[i] = __float_to_bfloat(in[i]);
+}
+}
+#ifdef __VECTOR3D_X86_DISPATCH
+// AVX2 and F16C: 8 values per register
+#if defined(__clang__)
+#pragma clang attribute push(__attribute__((target("avx2,f16c"))), apply_to = function)
+#else
+#pragma GCC push_options
+#pragma GCC target("avx2,f16c")
+#endif
+namespace __isa_avx2 {
+inline void __half_to_float_n(const std::uint16_t* in, float* out, const std::size_t n) noexcept {
+    std::size_t i = 0;
+    for (; i + 8 <= n; i += 8)
+        _mm256_storeu_ps(out + i, _mm256_cvtph_ps(_mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i))));
+    __isa_scalar::__half_to_float_n(in + i, out + i, n - i);
+}
+inline void __float_to_half_n(const float* in, std::uint16_t* out, const std::size_t n) noexcept {
+    std::size_t i = 0;
+    for (; i + 8 <= n; i += 8)
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), _mm256_cvtps_ph(_mm256_loadu_ps(in + i), _MM_FROUND_TO_NEAREST_INT));
+    __isa_scalar::__float_to_half_n(in + i, out + i, n - i);
+}
+inline void __bfloat_to_float_n(const std::uint16_t* in, float* out, const std::size_t n) noexcept {
+    std::size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        const __m256i b = _mm256_cvtepu16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i)));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), _mm256_slli_epi32(b, 16));
+    }
+    __isa_scalar::__bfloat_to_float_n(in + i, out + i, n - i);
+}
+inline void __float_to_bfloat_n(const float* in, std::uint16_t* out, const std::size_t n) noexcept {
+    std::size_t i = 0;
+    const __m256i bias = _mm256_set1_epi32(0x7fff), one = _mm256_set1_epi32(1), quiet = _mm256_set1_epi32(0x40);
+    for (; i + 8 <= n; i += 8) {
+        const __m256 f = _mm256_loadu_ps(in + i);
+        const __m256i x = _mm256_castps_si256(f);
+        const __m256i odd = _mm256_and_si256(_mm256_srli_epi32(x, 16), one);
+        const __m256i rounded = _mm256_srli_epi32(_mm256_add_epi32(x, _mm256_add_epi32(bias, odd)), 16);
+        const __m256i nan = _mm256_or_si256(_mm256_srli_epi32(x, 16), quiet);
+        const __m256i b = _mm256_blendv_epi8(rounded, nan, _mm256_castps_si256(_mm256_cmp_ps(f, f, _CMP_UNORD_Q)));
+        // Packing works within 128 bit lanes, the permutation puts the two halves together
+        const __m256i packed = _mm256_permute4x64_epi64(_mm256_packus_epi32(b, b), 0x08);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), _mm256_castsi256_si128(packed));
+    }
+    __isa_scalar::__float_to_bfloat_n(in + i, out + i, n - i);
+}
+}
+#if defined(__clang__)
+#pragma clang attribute pop
+#else
+#pragma GCC pop_options
+#endif
+// AVX-512: 16 values per register. The conversions of binary16 are in AVX-512F, AVX-512 FP16 is not needed.
+#if defined(__clang__)
+#pragma clang attribute push(__attribute__((target("avx512f"))), apply_to = function)
+#else
+#pragma GCC push_options
+#pragma GCC target("avx512f")
+// GCC 12 warns about _mm512_undefined_epi32() inside its own intrinsics
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#endif
+namespace __isa_avx512 {
+inline void __half_to_float_n(const std::uint16_t* in, float* out, const std::size_t n) noexcept {
+    std::size_t i = 0;
+    for (; i + 16 <= n; i += 16)
+        _mm512_storeu_ps(out + i, _mm512_cvtph_ps(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + i))));
+    __isa_scalar::__half_to_float_n(in + i, out + i, n - i);
+}
+inline void __float_to_half_n(const float* in, std::uint16_t* out, const std::size_t n) noexcept {
+    std::size_t i = 0;
+    for (; i + 16 <= n; i += 16)
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), _mm512_cvtps_ph(_mm512_loadu_ps(in + i), _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC));
+    __isa_scalar::__float_to_half_n(in + i, out + i, n - i);
+}
+inline void __bfloat_to_float_n(const std::uint16_t* in, float* out, const std::size_t n) noexcept {
+    std::size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        const __m512i b = _mm512_cvtepu16_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + i)));
+        _mm512_storeu_si512(out + i, _mm512_slli_epi32(b, 16));
+    }
+    __isa_scalar::__bfloat_to_float_n(in + i, out + i, n - i);
+}
+// Not VCVTNEPS2BF16 of AVX-512 BF16: it flushes subnormals to zero
+inline void __float_to_bfloat_n(const float* in, std::uint16_t* out, const std::size_t n) noexcept {
+    std::size_t i = 0;
+    const __m512i bias = _mm512_set1_epi32(0x7fff), one = _mm512_set1_epi32(1), quiet = _mm512_set1_epi32(0x40);
+    for (; i + 16 <= n; i += 16) {
+        const __m512 f = _mm512_loadu_ps(in + i);
+        const __m512i x = _mm512_castps_si512(f);
+        const __m512i odd = _mm512_and_si512(_mm512_srli_epi32(x, 16), one);
+        const __m512i rounded = _mm512_srli_epi32(_mm512_add_epi32(x, _mm512_add_epi32(bias, odd)), 16);
+        const __m512i nan = _mm512_or_si512(_mm512_srli_epi32(x, 16), quiet);
+        const __m512i b = _mm512_mask_mov_epi32(rounded, _mm512_cmp_ps_mask(f, f, _CMP_UNORD_Q), nan);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), _mm512_cvtepi32_epi16(b));
+    }
+    __isa_scalar::__float_to_bfloat_n(in + i, out + i, n - i);
+}
+}
+#if defined(__clang__)
+#pragma clang attribute pop
+#else
+#pragma GCC diagnostic pop
+#pragma GCC pop_options
+#endif
+#endif
+
+struct __convert_table {
+    void (*half_to_float)(const std::uint16_t*, float*, std::size_t) noexcept;
+    void (*float_to_half)(const float*, std::uint16_t*, std::size_t) noexcept;
+    void (*bfloat_to_float)(const std::uint16_t*, float*, std::size_t) noexcept;
+    void (*float_to_bfloat)(const float*, std::uint16_t*, std::size_t) noexcept;
+};
+// Follows batch_isa(). The AVX2 kernels also need F16C, which every CPU with AVX2 has in practice.
+inline const __convert_table& __convert_kernels() noexcept {
+    static constexpr __convert_table scalar = {__isa_scalar::__half_to_float_n, __isa_scalar::__float_to_half_n,
+                                               __isa_scalar::__bfloat_to_float_n, __isa_scalar::__float_to_bfloat_n};
+#ifdef __VECTOR3D_X86_DISPATCH
+    static constexpr __convert_table avx2 = {__isa_avx2::__half_to_float_n, __isa_avx2::__float_to_half_n,
+                                             __isa_avx2::__bfloat_to_float_n, __isa_avx2::__float_to_bfloat_n};
+    static constexpr __convert_table avx512 = {__isa_avx512::__half_to_float_n, __isa_avx512::__float_to_half_n,
+                                               __isa_avx512::__bfloat_to_float_n, __isa_avx512::__float_to_bfloat_n};
+    static const bool f16c = (__builtin_cpu_init(), __builtin_cpu_supports("f16c"));
+    switch (batch_isa()) {
+    case simd_isa::avx512: return avx512;
+    case simd_isa::avx2: return f16c ? avx2 : scalar;
+    default: break;
+    }
+#endif
+    return scalar;
+}
+
+// Components of arrays of vectors of H, or of float, as one flat array
+template <typename V, typename H>
+inline constexpr bool __flat_vector_v = requires { V::size(); } && std::is_same_v<std::remove_cvref_t<decltype(std::declval<const V&>()[0])>, H>
+                                        && sizeof(V) == V::size() * sizeof(H);
+
+// out[i] = in[i] for n values, from 16 bits to float and back
+inline void batch_convert(const float16* in, float* out, const std::size_t n) noexcept {
+    __convert_kernels().half_to_float(reinterpret_cast<const std::uint16_t*>(in), out, n);
+}
+inline void batch_convert(const float* in, float16* out, const std::size_t n) noexcept {
+    __convert_kernels().float_to_half(in, reinterpret_cast<std::uint16_t*>(out), n);
+}
+inline void batch_convert(const bfloat16* in, float* out, const std::size_t n) noexcept {
+    __convert_kernels().bfloat_to_float(reinterpret_cast<const std::uint16_t*>(in), out, n);
+}
+inline void batch_convert(const float* in, bfloat16* out, const std::size_t n) noexcept {
+    __convert_kernels().float_to_bfloat(in, reinterpret_cast<std::uint16_t*>(out), n);
+}
+// n vectors (vector2D, vector3D or vectorND) of float16 or bfloat16 to vectors of float of the same dimension, and back
+template <typename V, typename W>
+    requires (V::size() == W::size() && ((__flat_vector_v<V, float16> || __flat_vector_v<V, bfloat16>) && __flat_vector_v<W, float>
+                                       || (__flat_vector_v<W, float16> || __flat_vector_v<W, bfloat16>) && __flat_vector_v<V, float>))
+inline void batch_convert(const V* in, W* out, const std::size_t n) noexcept {
+    using A = std::remove_cvref_t<decltype(std::declval<const V&>()[0])>;
+    using B = std::remove_cvref_t<decltype(std::declval<const W&>()[0])>;
+    batch_convert(reinterpret_cast<const A*>(in), reinterpret_cast<B*>(out), n * V::size());
+}
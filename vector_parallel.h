@@ -0,0 +1,299 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdlib>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "vector_array.h"
+
+/*
+ * This file is part of the Vector3D distribution (https://github.com/cdelv/Vector3D).
+ * Copyright (c) 2022 Carlos Andres del Valle.
+ *
+ * Vector3D is under the terms of the BSD-3 license. We welcome feedback and contributions.
+ *
+ * you should have received a copy of the BSD3 Public License
+ * along with this program. If not, see <https://github.com/cdelv/Vector3D> LICENSE.
+ *
+ *
+ * This library requires C++20.
+*/
+
+/*
+*  Work-stealing thread pool
+*  The workers are started once and kept. Every worker has its own queue of tasks: it runs the newest
+*  task of its queue first and, when the queue is empty, steals the oldest task of another one. A thread
+*  that waits for its tasks runs queued tasks meanwhile, so a parallel loop can be nested inside another
+*  one without blocking a worker.
+*
+*  parallel_for splits the index range in one contiguous block per thread, and every thread takes chunks
+*  of grain indices from the front of its own block. A thread that finishes its block takes chunks from
+*  the others, so uneven work per element is balanced. Block p of every loop goes to the same worker, so
+*  loops over the same arrays touch the same memory from the same thread. With the first-touch policy of
+*  Linux, arrays that are filled by a parallel loop then stay on the NUMA node of the threads that use them.
+*
+*  The pool of the library has one thread per hardware thread, the calling thread included. Set the
+*  environment variable VECTOR3D_THREADS to change that.
+*/
+class thread_pool {
+private:
+    struct __Queue {
+        std::mutex lock;
+        std::deque<std::function<void()>> tasks;
+    };
+    // Tasks of one call, which waits for them
+    struct __Group {
+        std::atomic<std::size_t> pending{0};
+        std::atomic<bool> failed{false};
+        std::exception_ptr error;
+        std::mutex lock;
+    };
+    // Worker of the calling thread: its pool and its queue
+    struct __Slot {
+        const thread_pool* pool = nullptr;
+        std::size_t index = 0;
+    };
+    static inline __Slot& __slot() noexcept {
+        static thread_local __Slot slot;
+        return slot;
+    }
+
+    // One queue per worker, and the last one for tasks from other threads
+    std::vector<std::unique_ptr<__Queue>> _queues;
+    std::vector<std::thread> _workers;
+    std::atomic<std::size_t> _queued{0};
+    std::mutex _sleep;
+    std::condition_variable _wake;
+    bool _stop = false;
+
+    inline std::size_t __self() const noexcept {
+        const __Slot &s = __slot();
+        return s.pool == this ? s.index : _workers.size();
+    }
+    inline void __push(const std::size_t q, std::function<void()> task) {
+        {
+            std::lock_guard<std::mutex> guard(_queues[q]->lock);
+            _queues[q]->tasks.push_back(std::move(task));
+            _queued.fetch_add(1);
+        }
+        std::lock_guard<std::mutex> guard(_sleep);
+        _wake.notify_one();
+    }
+    // Newest task of queue q, or oldest of another queue
+    inline bool __take(const std::size_t q, std::function<void()> &task) {
+        for (std::size_t k = 0; k < _queues.size(); ++k) {
+            __Queue &from = *_queues[(q + k) % _queues.size()];
+            std::lock_guard<std::mutex> guard(from.lock);
+            if (from.tasks.empty())
+                continue;
+            if (k == 0) {
+                task = std::move(from.tasks.back());
+                from.tasks.pop_back();
+            }
+            else {
+                task = std::move(from.tasks.front());
+                from.tasks.pop_front();
+            }
+            _queued.fetch_sub(1);
+            return true;
+        }
+        return false;
+    }
+    inline bool __run_one(const std::size_t q) {
+        std::function<void()> task;
+        if (!__take(q, task))
+            return false;
+        task();
+        return true;
+    }
+    inline void __work(const std::size_t index) {
+        __slot() = __Slot{this, index};
+        while (true) {
+            if (__run_one(index))
+                continue;
+            std::unique_lock<std::mutex> lock(_sleep);
+            _wake.wait(lock, [this] { return _stop || _queued.load() > 0; });
+            if (_stop && _queued.load() == 0)
+                return;
+        }
+    }
+    template <typename F>
+    static inline void __guarded(__Group &group, F &&f) noexcept {
+        if (group.failed.load(std::memory_order_relaxed))
+            return;
+        try {
+            f();
+        }
+        catch (...) {
+            std::lock_guard<std::mutex> guard(group.lock);
+            if (!group.failed.exchange(true))
+                group.error = std::current_exception();
+        }
+    }
+    inline void __done(__Group &group) {
+        if (group.pending.fetch_sub(1) == 1) {
+            std::lock_guard<std::mutex> guard(_sleep);
+            _wake.notify_all();
+        }
+    }
+    // Runs queued tasks until the group is done
+    inline void __wait(__Group &group) {
+        const std::size_t self = __self();
+        while (group.pending.load() > 0) {
+            if (__run_one(self))
+                continue;
+            std::unique_lock<std::mutex> lock(_sleep);
+            _wake.wait(lock, [&] { return group.pending.load() == 0 || _queued.load() > 0; });
+        }
+    }
+
+public:
+    // threads counts the calling thread: a pool of 1 runs everything on it. 0 for one per hardware thread.
+    explicit thread_pool(std::size_t threads = 0) {
+        if (threads == 0)
+            threads = std::max(1u, std::thread::hardware_concurrency());
+        for (std::size_t i = 0; i < threads; ++i)
+            _queues.push_back(std::make_unique<__Queue>());
+        _workers.reserve(threads - 1);
+        for (std::size_t i = 0; i + 1 < threads; ++i)
+            _workers.emplace_back([this, i] { __work(i); });
+    }
+    thread_pool(const thread_pool&) = delete;
+    thread_pool& operator=(const thread_pool&) = delete;
+    // Runs the tasks left, then joins the workers
+    ~thread_pool() {
+        {
+            std::lock_guard<std::mutex> guard(_sleep);
+            _stop = true;
+        }
+        _wake.notify_all();
+        for (std::thread &w : _workers)
+            w.join();
+    }
+    // The pool of the library
+    static thread_pool& global() {
+        static thread_pool pool([] {
+            const char* env = std::getenv("VECTOR3D_THREADS");
+            return env ? std::strtoul(env, nullptr, 10) : 0ul;
+        }());
+        return pool;
+    }
+
+    // Threads that run tasks, the calling thread included
+    inline std::size_t size() const noexcept {
+        return _workers.size() + 1;
+    }
+
+    // Calls f(p) for every p in [0, parts), f(0) on the calling thread, and returns when they are all done.
+    // From outside the pool, part p is queued on worker p - 1. The first exception is rethrown, and the
+    // parts that haven't started when it happens are skipped.
+    template <typename F>
+    void run(const std::size_t parts, F &&f) {
+        if (parts == 0)
+            return;
+        if (parts == 1 || _workers.empty()) {
+            for (std::size_t p = 0; p < parts; ++p)
+                f(p);
+            return;
+        }
+        __Group group;
+        group.pending.store(parts - 1);
+        const std::size_t self = __self();
+        for (std::size_t p = 1; p < parts; ++p) {
+            const std::size_t q = self == _workers.size() ? (p - 1) % _workers.size() : self;
+            __push(q, [this, &group, &f, p] {
+                __guarded(group, [&] { f(p); });
+                __done(group);
+            });
+        }
+        __guarded(group, [&] { f(0); });
+        __wait(group);
+        if (group.error)
+            std::rethrow_exception(group.error);
+    }
+};
+
+/*
+*  Parallel loops
+*/
+struct parallel_options {
+    std::size_t grain = 1024;           // indices per chunk
+    std::size_t threads = 0;            // most threads to use, 0 for the whole pool
+    thread_pool* pool = nullptr;        // nullptr for thread_pool::global()
+};
+
+// Calls body(begin, end) on chunks that cover [0, n)
+template <typename F>
+void parallel_for(const std::size_t n, F &&body, const parallel_options &options = parallel_options()) {
+    thread_pool &pool = options.pool ? *options.pool : thread_pool::global();
+    const std::size_t grain = std::max<std::size_t>(options.grain, 1);
+    const std::size_t chunks = (n + grain - 1) / grain;
+    const std::size_t parts = std::min({chunks, pool.size(), options.threads ? options.threads : pool.size()});
+    if (parts <= 1) {
+        if (n > 0) body(std::size_t(0), n);
+        return;
+    }
+    // Next index and end of every block, a cache line apart
+    struct alignas(64) __Block {
+        std::atomic<std::size_t> next;
+        std::size_t end;
+    };
+    std::unique_ptr<__Block[]> blocks(new __Block[parts]);
+    for (std::size_t p = 0; p < parts; ++p) {
+        blocks[p].next.store(n * p / parts, std::memory_order_relaxed);
+        blocks[p].end = n * (p + 1) / parts;
+    }
+    pool.run(parts, [&](const std::size_t p) {
+        for (std::size_t k = 0; k < parts; ++k) {
+            __Block &b = blocks[(p + k) % parts];
+            for (std::size_t i = b.next.fetch_add(grain); i < b.end; i = b.next.fetch_add(grain))
+                body(i, std::min(i + grain, b.end));
+        }
+    });
+}
+// f(c[i]) for every element
+template <typename C, typename F>
+void parallel_for_each(C &c, F &&f, const parallel_options &options = parallel_options()) {
+    parallel_for(c.size(), [&](const std::size_t begin, const std::size_t end) {
+        for (std::size_t i = begin; i < end; ++i)
+            f(c[i]);
+    }, options);
+}
+// out[i] = f(in[i]). Like any expression, one returned by f must not refer to temporaries made inside f:
+// return a + b, or eval(a + (b ^ a)) where the cross product is a node of its own.
+template <typename In, typename Out, typename F>
+void parallel_transform(const In &in, Out &out, F &&f, const parallel_options &options = parallel_options()) {
+    if (out.size() != in.size()) throw std::length_error("parallel_transform: Size mismatch");
+    parallel_for(in.size(), [&](const std::size_t begin, const std::size_t end) {
+        for (std::size_t i = begin; i < end; ++i)
+            out[i] = f(in[i]);
+    }, options);
+}
+// out[i] = f(a[i], b[i])
+template <typename A, typename B, typename Out, typename F> requires (!std::is_same_v<std::remove_cvref_t<F>, parallel_options>)
+void parallel_transform(const A &a, const B &b, Out &out, F &&f, const parallel_options &options = parallel_options()) {
+    if (b.size() != a.size() || out.size() != a.size()) throw std::length_error("parallel_transform: Size mismatch");
+    parallel_for(a.size(), [&](const std::size_t begin, const std::size_t end) {
+        for (std::size_t i = begin; i < end; ++i)
+            out[i] = f(a[i], b[i]);
+    }, options);
+}
+// Evaluates an array expression into out in parallel, e.g. parallel_assign(P, P + dt * V)
+template <typename Out, typename E, std::size_t N>
+void parallel_assign(Out &out, const __ArrayExpression<E, N> &expr, const parallel_options &options = parallel_options()) {
+    const E &e = static_cast<const E&>(expr);
+    if (out.size() != e.size()) throw std::length_error("parallel_assign: Size mismatch");
+    parallel_for(e.size(), [&](const std::size_t begin, const std::size_t end) {
+        for (std::size_t i = begin; i < end; ++i)
+            out[i] = e[i];
+    }, options);
+}
@@ -0,0 +1,189 @@
+#pragma once
+#include <algorithm>
+#include <concepts>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include "vector_array.h"
+
+/*
+ * This file is part of the Vector3D distribution (https://github.com/cdelv/Vector3D).
+ * Copyright (c) 2022 Carlos Andres del Valle.
+ *
+ * Vector3D is under the terms of the BSD-3 license. We welcome feedback and contributions.
+ *
+ * you should have received a copy of the BSD3 Public License
+ * along with this program. If not, see <https://github.com/cdelv/Vector3D> LICENSE.
+ *
+ *
+ * This library requires C++20.
+*/
+
+/*
+*  Quantized arrays of 3D vectors.
+*  Every component is stored as a 16 or 32 bit fixed-point number relative to a bounding box: the code c
+*  stands for lower + c * step, with step = (upper - lower) / (2^bits - 1) on each axis. Encoding rounds
+*  to the nearest code, so inside the box the error is at most step / 2 per component. Outside the box,
+*  components are clamped to it. Like vector3DArray, the components are stored in three aligned arrays,
+*  so a vector of 16 bit codes takes 6 bytes instead of 24.
+*/
+template <std::unsigned_integral Q, std::floating_point T = double>
+class quantized3DArray : public __ArrayExpression<quantized3DArray<Q, T>, 3> {
+private:
+    static_assert(sizeof(Q) <= sizeof(std::uint32_t), "quantized3DArray: codes must be 16 or 32 bits");
+    static_assert(std::numeric_limits<Q>::digits <= std::numeric_limits<T>::digits, "quantized3DArray: T can't hold every code");
+    static constexpr std::size_t __lane = 64 / sizeof(Q);
+    static constexpr T __max_code = static_cast<T>(std::numeric_limits<Q>::max());
+    std::vector<Q, __AlignedAllocator<Q>> data;
+    std::size_t n = 0;
+    std::size_t stride = 0;
+    vector3D<T> _lower, _step, _inverse;
+
+    static inline constexpr std::size_t __padded(const std::size_t count) noexcept {
+        return (count + __lane - 1) / __lane * __lane;
+    }
+    inline void __box(const vector3D<T> &lower, const vector3D<T> &step) {
+        for (std::size_t k = 0; k < 3; ++k)
+            if (!(step[k] > 0) || !std::isfinite(step[k] * __max_code))
+                throw std::invalid_argument("quantized3DArray: the box must have a positive, finite size on every axis");
+        _lower = lower;
+        _step = step;
+        _inverse.load(1 / step.x, 1 / step.y, 1 / step.z);
+    }
+    // Rounds to the nearest code. The comparisons are written so that NaN goes to 0 and the loop vectorizes.
+    static inline constexpr Q __encode(const T x, const T lower, const T inverse) noexcept {
+        T t = (x - lower) * inverse;
+        t = t > 0 ? t : 0;
+        t = t < __max_code ? t : __max_code;
+        return static_cast<Q>(t + T(0.5));
+    }
+    static inline constexpr T __decode(const Q c, const T lower, const T step) noexcept {
+        return lower + static_cast<T>(c) * step;
+    }
+    template <typename E>
+    inline void __assign(const E &expr) noexcept {
+        Q* X = x();
+        Q* Y = y();
+        Q* Z = z();
+        __VECTOR3D_IVDEP
+        for (std::size_t i = 0; i < n; ++i) {
+            const auto v = expr[i];
+            X[i] = __encode(v.x, _lower.x, _inverse.x);
+            Y[i] = __encode(v.y, _lower.y, _inverse.y);
+            Z[i] = __encode(v.z, _lower.z, _inverse.z);
+        }
+    }
+public:
+    inline std::size_t size() const noexcept {
+        return n;
+    }
+
+    quantized3DArray() = default;
+    // Every vector at lower. The box goes from lower to upper, with the finest step that the codes allow.
+    quantized3DArray(const std::size_t size, const vector3D<T> &lower, const vector3D<T> &upper)
+        : data(3 * __padded(size)), n(size), stride(__padded(size)) {
+        __box(lower, (upper - lower) / __max_code);
+    }
+    // The box goes from lower as far as the codes reach with the given step (twice the largest error)
+    quantized3DArray(const std::size_t size, const vector3D<T> &lower, const T step)
+        : data(3 * __padded(size)), n(size), stride(__padded(size)) {
+        __box(lower, vector3D<T>(step, step, step));
+    }
+    template <typename E>
+    quantized3DArray(const __ArrayExpression<E, 3> &expr, const vector3D<T> &lower, const vector3D<T> &upper)
+        : quantized3DArray(expr.size(), lower, upper) {
+        __assign(static_cast<const E&>(expr));
+    }
+    template <typename E>
+    quantized3DArray(const __ArrayExpression<E, 3> &expr, const vector3D<T> &lower, const T step)
+        : quantized3DArray(expr.size(), lower, step) {
+        __assign(static_cast<const E&>(expr));
+    }
+    // In the bounding box of the vectors. An axis on which they are all equal gets a box of size 1.
+    static quantized3DArray fit(const vector3DArray<T> &vectors) {
+        vector3D<T> lower(0, 0, 0), upper(1, 1, 1);
+        const T* c[3] = {vectors.x(), vectors.y(), vectors.z()};
+        for (std::size_t k = 0; k < 3 && vectors.size() > 0; ++k) {
+            const auto [lo, hi] = std::minmax_element(c[k], c[k] + vectors.size());
+            lower[k] = *lo;
+            upper[k] = *hi > *lo ? *hi : *lo + 1;
+        }
+        return quantized3DArray(vectors, lower, upper);
+    }
+
+    // Box and step on every axis
+    inline const vector3D<T>& lower() const noexcept { return _lower; }
+    inline vector3D<T> upper() const noexcept { return _lower + __max_code * _step; }
+    inline const vector3D<T>& step() const noexcept { return _step; }
+    // Largest error of a component inside the box
+    inline vector3D<T> max_error() const noexcept { return _step / T(2); }
+
+    // Code arrays
+    inline Q* x() noexcept { return data.data(); }
+    inline Q* y() noexcept { return data.data() + stride; }
+    inline Q* z() noexcept { return data.data() + 2 * stride; }
+    inline const Q* x() const noexcept { return data.data(); }
+    inline const Q* y() const noexcept { return data.data() + stride; }
+    inline const Q* z() const noexcept { return data.data() + 2 * stride; }
+
+    // Decoded on the fly, so the array can be used in array expressions
+    inline vector3D<T> operator[](const std::size_t i) const noexcept {
+        return vector3D<T>(__decode(x()[i], _lower.x, _step.x), __decode(y()[i], _lower.y, _step.y), __decode(z()[i], _lower.z, _step.z));
+    }
+    inline vector3D<T> at(const std::size_t i) const {
+        if (i >= n) throw std::out_of_range("quantized3DArray: Index out of range");
+        return (*this)[i];
+    }
+    template <typename E>
+    inline void set(const std::size_t i, const __VecExpression<E, 3> &v) noexcept {
+        x()[i] = __encode(v.template get<0>(), _lower.x, _inverse.x);
+        y()[i] = __encode(v.template get<1>(), _lower.y, _inverse.y);
+        z()[i] = __encode(v.template get<2>(), _lower.z, _inverse.z);
+    }
+    // Encodes an array expression of the same size, in the same box
+    template <typename E>
+    inline quantized3DArray& operator=(const __ArrayExpression<E, 3> &expr) {
+        if (expr.size() != n) throw std::length_error("quantized3DArray: Size mismatch");
+        __assign(static_cast<const E&>(expr));
+        return *this;
+    }
+
+    /*
+    *  Batch kernels: one loop per component over plain arrays, which the compiler vectorizes.
+    */
+    inline void encode(const vector3DArray<T> &vectors) {
+        if (vectors.size() != n) throw std::length_error("quantized3DArray: Size mismatch");
+        const T* in[3] = {vectors.x(), vectors.y(), vectors.z()};
+        for (std::size_t k = 0; k < 3; ++k) {
+            const T* __restrict s = in[k];
+            Q* __restrict c = data.data() + k * stride;
+            const T lower = _lower[k], inverse = _inverse[k];
+            __VECTOR3D_IVDEP
+            for (std::size_t i = 0; i < n; ++i)
+                c[i] = __encode(s[i], lower, inverse);
+        }
+    }
+    inline void decode(vector3DArray<T> &vectors) const {
+        if (vectors.size() != n)
+            vectors = vector3DArray<T>(n);
+        T* out[3] = {vectors.x(), vectors.y(), vectors.z()};
+        for (std::size_t k = 0; k < 3; ++k) {
+            const Q* __restrict c = data.data() + k * stride;
+            T* __restrict d = out[k];
+            const T lower = _lower[k], step = _step[k];
+            __VECTOR3D_IVDEP
+            for (std::size_t i = 0; i < n; ++i)
+                d[i] = __decode(c[i], lower, step);
+        }
+    }
+    inline vector3DArray<T> decode() const {
+        vector3DArray<T> vectors(n);
+        decode(vectors);
+        return vectors;
+    }
+};
+template <std::floating_point T = double>
+using quantized16_3DArray = quantized3DArray<std::uint16_t, T>;
+template <std::floating_point T = double>
+using quantized32_3DArray = quantized3DArray<std::uint32_t, T>;
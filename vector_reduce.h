@@ -0,0 +1,455 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <functional>
+#include <limits>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "vector.h"
+#include "vector_parallel.h"
+
+/*
+ * This file is part of the Vector3D distribution (https://github.com/cdelv/Vector3D).
+ * Copyright (c) 2022 Carlos Andres del Valle.
+ *
+ * Vector3D is under the terms of the BSD-3 license. We welcome feedback and contributions.
+ *
+ * you should have received a copy of the BSD3 Public License
+ * along with this program. If not, see <https://github.com/cdelv/Vector3D> LICENSE.
+ *
+ *
+ * This library requires C++20.
+*/
+
+/*
+*  Parallel reductions over arrays of vectors (vector2D, vector3D or vectorND), passed as a pointer and
+*  a count or as a std::vector: sum, weighted sum, mean, weighted mean, component-wise minimum and
+*  maximum, bounding box, largest norm, and covariance.
+*  The array is split in one contiguous range per thread of the pool (vector_parallel.h), each of at least
+*  grain vectors, so small arrays stay on the calling thread. Within a range, the vectors are read as one
+*  flat array of components into several independent accumulators, a loop that the compiler vectorizes
+*  without reassociating anything.
+*  The partial results are combined in order. Since the grouping of the additions depends on the number
+*  of threads, the last bits of a floating point sum can change with it.
+*
+*  With deterministic set, the array is instead cut in blocks of a fixed size, whatever the threads and
+*  the grain, and the results of the blocks are combined in a fixed pairwise tree. The result is then the
+*  same to the last bit for any number of threads and any pool, on every run of the same program.
+*/
+struct reduce_options {
+    std::size_t threads = 0;            // 0 for one per thread of the pool
+    std::size_t grain = 1 << 15;        // fewest vectors per thread
+    thread_pool* pool = nullptr;        // nullptr for thread_pool::global()
+    bool deterministic = false;         // the same bits for any threads and grain
+};
+
+// Vectors per block of a deterministic reduction. Changing it changes the results.
+inline constexpr std::size_t __reduce_block = 1 << 12;
+
+// Unroll the following loop of a fixed number of iterations, so that its accumulators stay in registers
+#if defined(__clang__)
+#define __VECTOR3D_UNROLL _Pragma("clang loop unroll(full)")
+#elif defined(__GNUC__)
+#define __VECTOR3D_UNROLL _Pragma("GCC unroll 64")
+#else
+#define __VECTOR3D_UNROLL
+#endif
+
+// Components and dimension of the vector types
+template <typename V>
+using __reduce_component_t = std::remove_cvref_t<decltype(std::declval<const V&>()[0])>;
+template <typename V>
+inline constexpr bool __reducible_v = requires { V::size(); } && __Number<__reduce_component_t<V>>
+                                      && sizeof(V) == V::size() * sizeof(__reduce_component_t<V>);
+// Vectors per block of independent accumulators. Large vectors have enough components on their own.
+template <std::size_t N>
+inline constexpr std::size_t __reduce_lanes = N >= 8 ? 1 : 4;
+
+// Splits [0, n) in contiguous ranges, calls chunk(begin, end) on each one in the pool, and combines the results in order,
+// or in a tree over blocks of a fixed size for a deterministic reduction
+template <typename R, typename Chunk, typename Combine>
+inline R __parallel_reduce(const std::size_t n, const reduce_options &options, R init, Chunk &&chunk, Combine &&combine) {
+    thread_pool &pool = options.pool ? *options.pool : thread_pool::global();
+    const std::size_t grain = std::max<std::size_t>(options.grain, 1);
+    if (options.deterministic) {
+        const std::size_t blocks = (n + __reduce_block - 1) / __reduce_block;
+        if (blocks == 0)
+            return init;
+        std::vector<R> partial(blocks, init);
+        parallel_options o;
+        o.grain = (grain + __reduce_block - 1) / __reduce_block;
+        o.threads = options.threads;
+        o.pool = &pool;
+        parallel_for(blocks, [&](const std::size_t begin, const std::size_t end) {
+            for (std::size_t b = begin; b < end; ++b)
+                partial[b] = chunk(b * __reduce_block, std::min(n, (b + 1) * __reduce_block));
+        }, o);
+        for (std::size_t width = 1; width < blocks; width *= 2)
+            for (std::size_t b = 0; b + width < blocks; b += 2 * width)
+                partial[b] = combine(std::move(partial[b]), std::move(partial[b + width]));
+        return combine(std::move(init), std::move(partial[0]));
+    }
+    const std::size_t parts = std::min(options.threads ? options.threads : pool.size(), (n + grain - 1) / grain);
+    if (parts <= 1)
+        return n > 0 ? combine(std::move(init), chunk(std::size_t(0), n)) : init;
+    std::vector<R> partial(parts, init);
+    pool.run(parts, [&](const std::size_t p) {
+        partial[p] = chunk(n * p / parts, n * (p + 1) / parts);
+    });
+    for (R &p : partial)
+        init = combine(std::move(init), std::move(p));
+    return init;
+}
+template <typename V, typename A>
+inline V __to_vector(const A &a) noexcept {
+    V v;
+    for (std::size_t k = 0; k < V::size(); ++k)
+        v[k] = a[k];
+    return v;
+}
+
+/*
+*  Kernels over the vectors [begin, end) of a flat array of components
+*/
+// Partial sum of a range, with the rounding errors of kahan_sum in carry
+template <typename A, std::size_t N>
+struct __PartialSum {
+    std::array<A, N> sum{}, carry{};
+};
+template <typename P, typename A, std::size_t N>
+inline __PartialSum<A, N> __add_partials(__PartialSum<A, N> a, const __PartialSum<A, N> &b) noexcept {
+    for (std::size_t k = 0; k < N; ++k) {
+        if constexpr (std::is_same_v<P, kahan_sum>) {
+            __neumaier(a.sum[k], a.carry[k], b.sum[k]);
+            a.carry[k] += b.carry[k];
+        }
+        else a.sum[k] += b.sum[k];
+    }
+    return a;
+}
+// Vectors from which pairwise_sum halves a range
+inline constexpr std::size_t __pairwise_block = 256;
+// Sum of the vectors, or of w[i] * v[i], in accumulators of type A with policy P (widened_sum as naive_sum)
+template <typename P, typename A, std::size_t N, typename T, typename W>
+inline __PartialSum<A, N> __sum_kernel(const T *flat, const W *weights, const std::size_t begin, const std::size_t end) noexcept {
+    if constexpr (std::is_same_v<P, pairwise_sum>) {
+        if (end - begin > __pairwise_block) {
+            const std::size_t middle = begin + (end - begin) / 2;
+            return __add_partials<P>(__sum_kernel<P, A, N>(flat, weights, begin, middle), __sum_kernel<P, A, N>(flat, weights, middle, end));
+        }
+    }
+    constexpr std::size_t L = __reduce_lanes<N>;
+    const auto term = [flat, weights](const std::size_t i, const std::size_t k) {
+        if constexpr (std::is_same_v<W, void>) return static_cast<A>(flat[i * N + k]);
+        else return static_cast<A>(weights[i]) * static_cast<A>(flat[i * N + k]);
+    };
+    const auto add = [](A &s, A &c, const A x) {
+        if constexpr (std::is_same_v<P, kahan_sum>) __neumaier(s, c, x);
+        else s += x;
+    };
+    A acc[L * N] = {};
+    A carry[L * N] = {};
+    std::size_t i = begin;
+    for (; i + L <= end; i += L) {
+        __VECTOR3D_UNROLL
+        for (std::size_t j = 0; j < L * N; ++j) {
+            if constexpr (std::is_same_v<P, kahan_sum> && std::is_floating_point_v<A>) {
+                // Kahan's compensation, without the branch of Neumaier's so that the lanes vectorize
+                const A y = term(i + j / N, j % N) + carry[j];
+                const A t = acc[j] + y;
+                carry[j] = y - (t - acc[j]);
+                acc[j] = t;
+            }
+            else add(acc[j], carry[j], term(i + j / N, j % N));
+        }
+    }
+    __PartialSum<A, N> s;
+    for (std::size_t l = 0; l < L; ++l)
+        for (std::size_t k = 0; k < N; ++k) {
+            add(s.sum[k], s.carry[k], acc[l * N + k]);
+            s.carry[k] += carry[l * N + k];
+        }
+    for (; i < end; ++i)
+        for (std::size_t k = 0; k < N; ++k)
+            add(s.sum[k], s.carry[k], term(i, k));
+    return s;
+}
+// Bounds of no values: every value is below lo and above hi. NaN compares false, so it never replaces them.
+template <typename T>
+inline constexpr T __lowest_bound = std::numeric_limits<T>::has_infinity ? std::numeric_limits<T>::infinity() : std::numeric_limits<T>::max();
+template <typename T>
+inline constexpr T __highest_bound = std::numeric_limits<T>::has_infinity ? -std::numeric_limits<T>::infinity() : std::numeric_limits<T>::lowest();
+// Minimum and maximum of every component, with NaNs skipped
+template <typename T, std::size_t N>
+inline std::pair<std::array<T, N>, std::array<T, N>> __bounds_kernel(const T *flat, const std::size_t begin, const std::size_t end) noexcept {
+    constexpr std::size_t L = __reduce_lanes<N>;
+    T lo[L * N], hi[L * N];
+    for (std::size_t j = 0; j < L * N; ++j) {
+        lo[j] = __lowest_bound<T>;
+        hi[j] = __highest_bound<T>;
+    }
+    std::size_t i = begin;
+    for (; i + L <= end; i += L) {
+        const T* p = flat + i * N;
+        __VECTOR3D_UNROLL
+        for (std::size_t j = 0; j < L * N; ++j) {
+            lo[j] = p[j] < lo[j] ? p[j] : lo[j];
+            hi[j] = p[j] > hi[j] ? p[j] : hi[j];
+        }
+    }
+    std::pair<std::array<T, N>, std::array<T, N>> b;
+    for (std::size_t k = 0; k < N; ++k) {
+        b.first[k] = lo[k];
+        b.second[k] = hi[k];
+        for (std::size_t l = 1; l < L; ++l) {
+            b.first[k] = lo[l * N + k] < b.first[k] ? lo[l * N + k] : b.first[k];
+            b.second[k] = hi[l * N + k] > b.second[k] ? hi[l * N + k] : b.second[k];
+        }
+    }
+    for (; i < end; ++i)
+        for (std::size_t k = 0; k < N; ++k) {
+            const T c = flat[i * N + k];
+            b.first[k] = c < b.first[k] ? c : b.first[k];
+            b.second[k] = c > b.second[k] ? c : b.second[k];
+        }
+    return b;
+}
+template <typename T, std::size_t N>
+inline T __max_norm2_kernel(const T *flat, const std::size_t begin, const std::size_t end) noexcept {
+    constexpr std::size_t L = __reduce_lanes<N>;
+    T m[L] = {};
+    std::size_t i = begin;
+    for (; i + L <= end; i += L)
+        __VECTOR3D_UNROLL
+        for (std::size_t l = 0; l < L; ++l) {
+            const T* p = flat + (i + l) * N;
+            T s = p[0] * p[0];
+            for (std::size_t k = 1; k < N; ++k)
+                s += p[k] * p[k];
+            m[l] = s > m[l] ? s : m[l];
+        }
+    for (; i < end; ++i) {
+        const T* p = flat + i * N;
+        T s = p[0] * p[0];
+        for (std::size_t k = 1; k < N; ++k)
+            s += p[k] * p[k];
+        m[0] = s > m[0] ? s : m[0];
+    }
+    return *std::max_element(m, m + L);
+}
+// Sum of the outer products of the deviations from the mean, upper triangle by rows
+template <typename T, std::size_t N>
+inline std::array<T, N * (N + 1) / 2> __scatter_kernel(const T *flat, const std::array<T, N> &mean, const std::size_t begin, const std::size_t end) noexcept {
+    std::array<T, N * (N + 1) / 2> s{};
+    for (std::size_t i = begin; i < end; ++i) {
+        T d[N];
+        __VECTOR3D_UNROLL
+        for (std::size_t k = 0; k < N; ++k)
+            d[k] = flat[i * N + k] - mean[k];
+        std::size_t j = 0;
+        __VECTOR3D_UNROLL
+        for (std::size_t a = 0; a < N; ++a)
+            __VECTOR3D_UNROLL
+            for (std::size_t b = a; b < N; ++b, ++j)
+                s[j] += d[a] * d[b];
+    }
+    return s;
+}
+template <typename A>
+inline A __add_arrays(A a, const A &b) noexcept {
+    for (std::size_t k = 0; k < a.size(); ++k)
+        a[k] += b[k];
+    return a;
+}
+
+/*
+*  Reductions
+*/
+// Vector of the same dimension with components of type A
+template <typename V, typename A>
+using __rebind_t = std::conditional_t<V::size() == 3, vector3D<A>, std::conditional_t<V::size() == 2, vector2D<A>, vectorND<A, V::size()>>>;
+// Type of a sum of vectors of type V with policy P: V, or the wider vector of widened_sum
+template <typename P, typename V>
+using __sum_t = std::conditional_t<std::is_same_v<P, widened_sum>, __rebind_t<V, __widened_t<__reduce_component_t<V>>>, V>;
+template <typename P, typename V, typename W>
+inline __sum_t<P, V> __parallel_sum(const V *v, const W *w, const std::size_t n, const reduce_options &options) {
+    using A = __accumulator_t<P, __reduce_component_t<V>>;
+    constexpr std::size_t N = V::size();
+    using S = __PartialSum<A, N>;
+    const __reduce_component_t<V>* flat = reinterpret_cast<const __reduce_component_t<V>*>(v);
+    const S s = __parallel_reduce(n, options, S(), [flat, w](const std::size_t b, const std::size_t e) {
+        return __sum_kernel<P, A, N>(flat, w, b, e);
+    }, __add_partials<P, A, N>);
+    __sum_t<P, V> r;
+    for (std::size_t k = 0; k < N; ++k)
+        r[k] = s.sum[k] + s.carry[k];
+    return r;
+}
+
+// Sum of the vectors, with an accumulation policy (vector.h) or the one of their components. Zero for an
+// empty array. widened_sum returns a vector of the wider type, e.g. a vector3D<double> for vector3D<float>.
+template <__AccumulationPolicy P, typename V> requires __reducible_v<V>
+inline __sum_t<P, V> parallel_sum(const V *v, const std::size_t n, P, const reduce_options &options = reduce_options()) {
+    return __parallel_sum<P, V, void>(v, nullptr, n, options);
+}
+template <typename V> requires __reducible_v<V>
+inline auto parallel_sum(const V *v, const std::size_t n, const reduce_options &options = reduce_options()) {
+    return parallel_sum(v, n, accumulation_policy_t<__reduce_component_t<V>>(), options);
+}
+// Sum of w[i] * v[i]
+template <__AccumulationPolicy P, typename V, __Number W> requires __reducible_v<V>
+inline __sum_t<P, V> parallel_weighted_sum(const V *v, const W *w, const std::size_t n, P, const reduce_options &options = reduce_options()) {
+    return __parallel_sum<P, V, W>(v, w, n, options);
+}
+template <typename V, __Number W> requires __reducible_v<V>
+inline auto parallel_weighted_sum(const V *v, const W *w, const std::size_t n, const reduce_options &options = reduce_options()) {
+    return parallel_weighted_sum(v, w, n, accumulation_policy_t<__reduce_component_t<V>>(), options);
+}
+template <__AccumulationPolicy P, typename V> requires __reducible_v<V>
+inline __sum_t<P, V> parallel_mean(const V *v, const std::size_t n, P policy, const reduce_options &options = reduce_options()) {
+    if (n == 0) throw std::length_error("parallel_mean: empty array");
+    return parallel_sum(v, n, policy, options) / static_cast<__reduce_component_t<__sum_t<P, V>>>(n);
+}
+template <typename V> requires __reducible_v<V>
+inline auto parallel_mean(const V *v, const std::size_t n, const reduce_options &options = reduce_options()) {
+    return parallel_mean(v, n, accumulation_policy_t<__reduce_component_t<V>>(), options);
+}
+// Sum of w[i] * v[i] over the sum of w[i], e.g. the center of mass
+template <__AccumulationPolicy P, typename V, __Number W> requires __reducible_v<V>
+inline __sum_t<P, V> parallel_weighted_mean(const V *v, const W *w, const std::size_t n, P policy, const reduce_options &options = reduce_options()) {
+    using A = __accumulator_t<P, W>;
+    using S = __PartialSum<A, 1>;
+    const S total = __parallel_reduce(n, options, S(), [w](const std::size_t b, const std::size_t e) {
+        return __sum_kernel<P, A, 1>(w, static_cast<const void*>(nullptr), b, e);
+    }, __add_partials<P, A, 1>);
+    const A t = total.sum[0] + total.carry[0];
+    if (t == A(0)) throw std::domain_error("parallel_weighted_mean: the weights add up to zero");
+    return parallel_weighted_sum(v, w, n, policy, options) / static_cast<__reduce_component_t<__sum_t<P, V>>>(t);
+}
+template <typename V, __Number W> requires __reducible_v<V>
+inline auto parallel_weighted_mean(const V *v, const W *w, const std::size_t n, const reduce_options &options = reduce_options()) {
+    return parallel_weighted_mean(v, w, n, accumulation_policy_t<__reduce_component_t<V>>(), options);
+}
+// Component-wise minimum and maximum: the corners of the bounding box
+template <typename V> requires __reducible_v<V> && std::is_arithmetic_v<__reduce_component_t<V>>
+inline std::pair<V, V> parallel_bounds(const V *v, const std::size_t n, const reduce_options &options = reduce_options()) {
+    using T = __reduce_component_t<V>;
+    constexpr std::size_t N = V::size();
+    using B = std::pair<std::array<T, N>, std::array<T, N>>;
+    if (n == 0) throw std::length_error("parallel_bounds: empty array");
+    const T* flat = reinterpret_cast<const T*>(v);
+    B none;
+    none.first.fill(__lowest_bound<T>);
+    none.second.fill(__highest_bound<T>);
+    B b = __parallel_reduce(n, options, none, [flat](const std::size_t b, const std::size_t e) {
+        return __bounds_kernel<T, N>(flat, b, e);
+    }, [](B a, const B &c) {
+        for (std::size_t k = 0; k < N; ++k) {
+            a.first[k] = c.first[k] < a.first[k] ? c.first[k] : a.first[k];
+            a.second[k] = c.second[k] > a.second[k] ? c.second[k] : a.second[k];
+        }
+        return a;
+    });
+    // A component that is NaN everywhere has no bounds
+    for (std::size_t k = 0; k < N; ++k)
+        if (b.first[k] > b.second[k])
+            b.first[k] = b.second[k] = std::numeric_limits<T>::quiet_NaN();
+    return {__to_vector<V>(b.first), __to_vector<V>(b.second)};
+}
+template <typename V> requires __reducible_v<V> && std::is_arithmetic_v<__reduce_component_t<V>>
+inline V parallel_min(const V *v, const std::size_t n, const reduce_options &options = reduce_options()) {
+    return parallel_bounds(v, n, options).first;
+}
+template <typename V> requires __reducible_v<V> && std::is_arithmetic_v<__reduce_component_t<V>>
+inline V parallel_max(const V *v, const std::size_t n, const reduce_options &options = reduce_options()) {
+    return parallel_bounds(v, n, options).second;
+}
+// Largest norm. Zero for an empty array.
+template <typename V> requires __reducible_v<V> && std::is_floating_point_v<__reduce_component_t<V>>
+inline __reduce_component_t<V> parallel_max_norm(const V *v, const std::size_t n, const reduce_options &options = reduce_options()) {
+    using T = __reduce_component_t<V>;
+    const T* flat = reinterpret_cast<const T*>(v);
+    return std::sqrt(__parallel_reduce(n, options, T(0), [flat](const std::size_t b, const std::size_t e) {
+        return __max_norm2_kernel<T, V::size()>(flat, b, e);
+    }, [](const T a, const T b) { return b > a ? b : a; }));
+}
+// Sample covariance matrix of the components, C[a][b] = sum (v[i][a] - mean[a]) (v[i][b] - mean[b]) / (n - 1)
+template <typename V> requires __reducible_v<V> && std::is_floating_point_v<__reduce_component_t<V>>
+inline std::array<std::array<__reduce_component_t<V>, V::size()>, V::size()> parallel_covariance(const V *v, const std::size_t n, const reduce_options &options = reduce_options()) {
+    using T = __reduce_component_t<V>;
+    constexpr std::size_t N = V::size();
+    using S = std::array<T, N * (N + 1) / 2>;
+    if (n < 2) throw std::length_error("parallel_covariance: needs at least two vectors");
+    const T* flat = reinterpret_cast<const T*>(v);
+    const auto m = parallel_mean(v, n, options);
+    std::array<T, N> mean;
+    for (std::size_t k = 0; k < N; ++k)
+        mean[k] = m[k];
+    const S s = __parallel_reduce(n, options, S{}, [flat, &mean](const std::size_t b, const std::size_t e) {
+        return __scatter_kernel<T, N>(flat, mean, b, e);
+    }, __add_arrays<S>);
+    std::array<std::array<T, N>, N> c;
+    for (std::size_t a = 0, j = 0; a < N; ++a)
+        for (std::size_t b = a; b < N; ++b, ++j)
+            c[a][b] = c[b][a] = s[j] / static_cast<T>(n - 1);
+    return c;
+}
+
+// The same over a std::vector
+template <__AccumulationPolicy P, typename V> requires __reducible_v<V>
+inline __sum_t<P, V> parallel_sum(const std::vector<V> &v, P policy, const reduce_options &options = reduce_options()) {
+    return parallel_sum(v.data(), v.size(), policy, options);
+}
+template <typename V> requires __reducible_v<V>
+inline auto parallel_sum(const std::vector<V> &v, const reduce_options &options = reduce_options()) {
+    return parallel_sum(v.data(), v.size(), options);
+}
+template <__AccumulationPolicy P, typename V, __Number W> requires __reducible_v<V>
+inline __sum_t<P, V> parallel_weighted_sum(const std::vector<V> &v, const std::vector<W> &w, P policy, const reduce_options &options = reduce_options()) {
+    if (w.size() != v.size()) throw std::length_error("parallel_weighted_sum: Size mismatch");
+    return parallel_weighted_sum(v.data(), w.data(), v.size(), policy, options);
+}
+template <typename V, __Number W> requires __reducible_v<V>
+inline auto parallel_weighted_sum(const std::vector<V> &v, const std::vector<W> &w, const reduce_options &options = reduce_options()) {
+    return parallel_weighted_sum(v, w, accumulation_policy_t<__reduce_component_t<V>>(), options);
+}
+template <__AccumulationPolicy P, typename V> requires __reducible_v<V>
+inline __sum_t<P, V> parallel_mean(const std::vector<V> &v, P policy, const reduce_options &options = reduce_options()) {
+    return parallel_mean(v.data(), v.size(), policy, options);
+}
+template <typename V> requires __reducible_v<V>
+inline auto parallel_mean(const std::vector<V> &v, const reduce_options &options = reduce_options()) {
+    return parallel_mean(v.data(), v.size(), options);
+}
+template <__AccumulationPolicy P, typename V, __Number W> requires __reducible_v<V>
+inline __sum_t<P, V> parallel_weighted_mean(const std::vector<V> &v, const std::vector<W> &w, P policy, const reduce_options &options = reduce_options()) {
+    if (w.size() != v.size()) throw std::length_error("parallel_weighted_mean: Size mismatch");
+    return parallel_weighted_mean(v.data(), w.data(), v.size(), policy, options);
+}
+template <typename V, __Number W> requires __reducible_v<V>
+inline auto parallel_weighted_mean(const std::vector<V> &v, const std::vector<W> &w, const reduce_options &options = reduce_options()) {
+    return parallel_weighted_mean(v, w, accumulation_policy_t<__reduce_component_t<V>>(), options);
+}
+template <typename V> requires __reducible_v<V> && std::is_arithmetic_v<__reduce_component_t<V>>
+inline std::pair<V, V> parallel_bounds(const std::vector<V> &v, const reduce_options &options = reduce_options()) {
+    return parallel_bounds(v.data(), v.size(), options);
+}
+template <typename V> requires __reducible_v<V> && std::is_arithmetic_v<__reduce_component_t<V>>
+inline V parallel_min(const std::vector<V> &v, const reduce_options &options = reduce_options()) {
+    return parallel_min(v.data(), v.size(), options);
+}
+template <typename V> requires __reducible_v<V> && std::is_arithmetic_v<__reduce_component_t<V>>
+inline V parallel_max(const std::vector<V> &v, const reduce_options &options = reduce_options()) {
+    return parallel_max(v.data(), v.size(), options);
+}
+template <typename V> requires __reducible_v<V> && std::is_floating_point_v<__reduce_component_t<V>>
+inline __reduce_component_t<V> parallel_max_norm(const std::vector<V> &v, const reduce_options &options = reduce_options()) {
+    return parallel_max_norm(v.data(), v.size(), options);
+}
+template <typename V> requires __reducible_v<V> && std::is_floating_point_v<__reduce_component_t<V>>
+inline auto parallel_covariance(const std::vector<V> &v, const reduce_options &options = reduce_options()) {
+    return parallel_covariance(v.data(), v.size(), options);
+}
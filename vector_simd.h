@@ -0,0 +1,622 @@
+#pragma once
+#include <atomic>
+#include <concepts>
+#include <cstdlib>
+#include <cstring>
+#include "vector_array.h"
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#define __VECTOR3D_X86_DISPATCH
+#include <immintrin.h>
+#endif
+
+/*
+ * This file is part of the Vector3D distribution (https://github.com/cdelv/Vector3D).
+ * Copyright (c) 2022 Carlos Andres del Valle.
+ *
+ * Vector3D is under the terms of the BSD-3 license. We welcome feedback and contributions.
+ *
+ * you should have received a copy of the BSD3 Public License
+ * along with this program. If not, see <https://github.com/cdelv/Vector3D> LICENSE.
+ *
+ *
+ * This library requires C++20.
+*/
+
+/*
+*  Batch kernels
+*  Hand written SIMD loops for the common operations over arrays of vectors.
+*  They work on arrays of vector2D/vector3D (array of structs) and on vector3DArray (structure of arrays).
+*  Each kernel is written once against a small wrapper around the registers of one instruction set.
+*  Elements that do not fill a whole register are done with the scalar version of the same wrapper,
+*  so every element of the output is computed with the same sequence of roundings.
+*
+*  The kernels are compiled for SSE4.2, AVX2 and AVX-512 regardless of the compiler flags. The best
+*  instruction set of the CPU is chosen the first time a kernel is called. Set the environment variable
+*  VECTOR3D_ISA to scalar, sse4.2, avx2 or avx512 to force a lower one.
+*/
+static_assert(sizeof(vector3D<double>) == 3 * sizeof(double) && sizeof(vector2D<double>) == 2 * sizeof(double),
+              "vector_simd.h: vector2D and vector3D must not have padding.");
+
+// Kernels of one instruction set for one type.
+// Each operation has an entry per layout: array of vector3D, array of vector2D and vector3DArray.
+enum __batch_layout : std::size_t { __aos3D = 0, __aos2D = 1, __soa3D = 2 };
+template <typename T>
+struct __batch_table {
+    void (*dot[3])(const T* const*, const T* const*, T*, std::size_t) noexcept;
+    void (*norm2[3])(const T* const*, T*, std::size_t, bool) noexcept;
+    void (*cross[3])(const T* const*, const T* const*, T* const*, std::size_t) noexcept;
+    void (*unit[3])(const T* const*, T* const*, std::size_t) noexcept;
+    void (*angle[3])(const T* const*, const T* const*, T*, std::size_t) noexcept;
+    void (*axpy)(T, const T*, T*, std::size_t) noexcept;
+};
+// Portable version, compiled with the flags of the translation unit
+namespace __isa_scalar {
+#include "vector_simd_kernels.inc"
+template <std::floating_point T>
+using __simd = __simd_scalar<T, false>;
+}
+#ifdef __VECTOR3D_X86_DISPATCH
+// SSE4.2: 2 doubles or 4 floats per register
+#if defined(__clang__)
+#pragma clang attribute push(__attribute__((target("sse4.2"))), apply_to = function)
+#else
+#pragma GCC push_options
+#pragma GCC target("sse4.2")
+#endif
+namespace __isa_sse42 {
+#include "vector_simd_kernels.inc"
+template <std::floating_point T>
+struct __simd;
+template <>
+struct __simd<double> {
+    using type = double;
+    using reg = __m128d;
+    using tail = __simd_scalar<double, false>;
+    static constexpr std::size_t width = 2;
+
+    static inline reg set1(const double a) noexcept { return _mm_set1_pd(a); }
+    static inline reg load(const double* p) noexcept { return _mm_loadu_pd(p); }
+    static inline void store(double* p, const reg a) noexcept { _mm_storeu_pd(p, a); }
+    // x0 y0 z0 x1 y1 z1 in (x0 y0) (z0 x1) (y1 z1)
+    template <std::size_t D>
+    static inline void load_aos(const double* p, reg (&r)[D]) noexcept {
+        const reg a = _mm_loadu_pd(p), b = _mm_loadu_pd(p + 2);
+        if constexpr (D == 2) {
+            r[0] = _mm_unpacklo_pd(a, b);
+            r[1] = _mm_unpackhi_pd(a, b);
+        }
+        else {
+            const reg c = _mm_loadu_pd(p + 4);
+            r[0] = _mm_shuffle_pd(a, b, 2);
+            r[1] = _mm_shuffle_pd(a, c, 1);
+            r[2] = _mm_shuffle_pd(b, c, 2);
+        }
+    }
+    template <std::size_t D>
+    static inline void store_aos(double* p, const reg (&r)[D]) noexcept {
+        if constexpr (D == 2) {
+            _mm_storeu_pd(p, _mm_unpacklo_pd(r[0], r[1]));
+            _mm_storeu_pd(p + 2, _mm_unpackhi_pd(r[0], r[1]));
+        }
+        else {
+            _mm_storeu_pd(p, _mm_shuffle_pd(r[0], r[1], 0));
+            _mm_storeu_pd(p + 2, _mm_shuffle_pd(r[2], r[0], 2));
+            _mm_storeu_pd(p + 4, _mm_shuffle_pd(r[1], r[2], 3));
+        }
+    }
+    static inline reg add(const reg a, const reg b) noexcept { return _mm_add_pd(a, b); }
+    static inline reg sub(const reg a, const reg b) noexcept { return _mm_sub_pd(a, b); }
+    static inline reg mul(const reg a, const reg b) noexcept { return _mm_mul_pd(a, b); }
+    static inline reg div(const reg a, const reg b) noexcept { return _mm_div_pd(a, b); }
+    static inline reg sqrt(const reg a) noexcept { return _mm_sqrt_pd(a); }
+    // No FMA before AVX2
+    static inline reg fmadd(const reg a, const reg b, const reg c) noexcept { return _mm_add_pd(_mm_mul_pd(a, b), c); }
+    static inline reg fmsub(const reg a, const reg b, const reg c) noexcept { return _mm_sub_pd(_mm_mul_pd(a, b), c); }
+};
+template <>
+struct __simd<float> {
+    using type = float;
+    using reg = __m128;
+    using tail = __simd_scalar<float, false>;
+    static constexpr std::size_t width = 4;
+
+    static inline reg set1(const float a) noexcept { return _mm_set1_ps(a); }
+    static inline reg load(const float* p) noexcept { return _mm_loadu_ps(p); }
+    static inline void store(float* p, const reg a) noexcept { _mm_storeu_ps(p, a); }
+    // x0 y0 z0 x1 | y1 z1 x2 y2 | z2 x3 y3 z3
+    template <std::size_t D>
+    static inline void load_aos(const float* p, reg (&r)[D]) noexcept {
+        const reg a = _mm_loadu_ps(p), b = _mm_loadu_ps(p + 4);
+        if constexpr (D == 2) {
+            r[0] = _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0));
+            r[1] = _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1));
+        }
+        else {
+            const reg c = _mm_loadu_ps(p + 8);
+            r[0] = _mm_shuffle_ps(a, _mm_shuffle_ps(b, c, _MM_SHUFFLE(1, 0, 3, 2)), _MM_SHUFFLE(3, 0, 3, 0));
+            r[1] = _mm_shuffle_ps(_mm_shuffle_ps(a, b, _MM_SHUFFLE(0, 0, 1, 1)), _mm_shuffle_ps(b, c, _MM_SHUFFLE(2, 2, 3, 3)), _MM_SHUFFLE(2, 0, 2, 0));
+            r[2] = _mm_shuffle_ps(_mm_shuffle_ps(a, b, _MM_SHUFFLE(1, 1, 2, 2)), _mm_shuffle_ps(c, c, _MM_SHUFFLE(3, 3, 0, 0)), _MM_SHUFFLE(2, 0, 2, 0));
+        }
+    }
+    template <std::size_t D>
+    static inline void store_aos(float* p, const reg (&r)[D]) noexcept {
+        if constexpr (D == 2) {
+            _mm_storeu_ps(p, _mm_unpacklo_ps(r[0], r[1]));
+            _mm_storeu_ps(p + 4, _mm_unpackhi_ps(r[0], r[1]));
+        }
+        else {
+            const reg x = r[0], y = r[1], z = r[2];
+            _mm_storeu_ps(p, _mm_shuffle_ps(_mm_shuffle_ps(x, y, _MM_SHUFFLE(0, 0, 0, 0)), _mm_shuffle_ps(z, x, _MM_SHUFFLE(1, 1, 0, 0)), _MM_SHUFFLE(2, 0, 2, 0)));
+            _mm_storeu_ps(p + 4, _mm_shuffle_ps(_mm_shuffle_ps(y, z, _MM_SHUFFLE(1, 1, 1, 1)), _mm_shuffle_ps(x, y, _MM_SHUFFLE(2, 2, 2, 2)), _MM_SHUFFLE(2, 0, 2, 0)));
+            _mm_storeu_ps(p + 8, _mm_shuffle_ps(_mm_shuffle_ps(z, x, _MM_SHUFFLE(3, 3, 2, 2)), _mm_shuffle_ps(y, z, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(2, 0, 2, 0)));
+        }
+    }
+    static inline reg add(const reg a, const reg b) noexcept { return _mm_add_ps(a, b); }
+    static inline reg sub(const reg a, const reg b) noexcept { return _mm_sub_ps(a, b); }
+    static inline reg mul(const reg a, const reg b) noexcept { return _mm_mul_ps(a, b); }
+    static inline reg div(const reg a, const reg b) noexcept { return _mm_div_ps(a, b); }
+    static inline reg sqrt(const reg a) noexcept { return _mm_sqrt_ps(a); }
+    static inline reg fmadd(const reg a, const reg b, const reg c) noexcept { return _mm_add_ps(_mm_mul_ps(a, b), c); }
+    static inline reg fmsub(const reg a, const reg b, const reg c) noexcept { return _mm_sub_ps(_mm_mul_ps(a, b), c); }
+};
+}
+#if defined(__clang__)
+#pragma clang attribute pop
+#else
+#pragma GCC pop_options
+#endif
+// AVX2 with FMA: 4 doubles or 8 floats per register
+#if defined(__clang__)
+#pragma clang attribute push(__attribute__((target("avx2,fma"))), apply_to = function)
+#else
+#pragma GCC push_options
+#pragma GCC target("avx2,fma")
+#endif
+namespace __isa_avx2 {
+#include "vector_simd_kernels.inc"
+template <std::floating_point T>
+struct __simd;
+template <>
+struct __simd<double> {
+    using type = double;
+    using reg = __m256d;
+    using tail = __simd_scalar<double, true>;
+    static constexpr std::size_t width = 4;
+
+    static inline reg set1(const double a) noexcept { return _mm256_set1_pd(a); }
+    static inline reg load(const double* p) noexcept { return _mm256_loadu_pd(p); }
+    static inline void store(double* p, const reg a) noexcept { _mm256_storeu_pd(p, a); }
+    // Two 128 bit halves: a and b in the low lane, c and d in the high one
+    static inline reg __halves(const double* a, const double* b) noexcept {
+        return _mm256_insertf128_pd(_mm256_castpd128_pd256(_mm_loadu_pd(a)), _mm_loadu_pd(b), 1);
+    }
+    static inline void __store_halves(double* a, double* b, const reg r) noexcept {
+        _mm_storeu_pd(a, _mm256_castpd256_pd128(r));
+        _mm_storeu_pd(b, _mm256_extractf128_pd(r, 1));
+    }
+    // Elements 0 and 1 in the low lanes and 2 and 3 in the high ones, then the shuffles of SSE on each lane
+    template <std::size_t D>
+    static inline void load_aos(const double* p, reg (&r)[D]) noexcept {
+        if constexpr (D == 2) {
+            const reg a = _mm256_loadu_pd(p), b = _mm256_loadu_pd(p + 4);
+            const reg lo = _mm256_permute2f128_pd(a, b, 0x20), hi = _mm256_permute2f128_pd(a, b, 0x31);
+            r[0] = _mm256_unpacklo_pd(lo, hi);
+            r[1] = _mm256_unpackhi_pd(lo, hi);
+        }
+        else {
+            const reg a = __halves(p, p + 6), b = __halves(p + 2, p + 8), c = __halves(p + 4, p + 10);
+            r[0] = _mm256_shuffle_pd(a, b, 0b1010);
+            r[1] = _mm256_shuffle_pd(a, c, 0b0101);
+            r[2] = _mm256_shuffle_pd(b, c, 0b1010);
+        }
+    }
+    template <std::size_t D>
+    static inline void store_aos(double* p, const reg (&r)[D]) noexcept {
+        if constexpr (D == 2) {
+            const reg lo = _mm256_unpacklo_pd(r[0], r[1]), hi = _mm256_unpackhi_pd(r[0], r[1]);
+            _mm256_storeu_pd(p, _mm256_permute2f128_pd(lo, hi, 0x20));
+            _mm256_storeu_pd(p + 4, _mm256_permute2f128_pd(lo, hi, 0x31));
+        }
+        else {
+            __store_halves(p, p + 6, _mm256_shuffle_pd(r[0], r[1], 0b0000));
+            __store_halves(p + 2, p + 8, _mm256_shuffle_pd(r[2], r[0], 0b1010));
+            __store_halves(p + 4, p + 10, _mm256_shuffle_pd(r[1], r[2], 0b1111));
+        }
+    }
+    static inline reg add(const reg a, const reg b) noexcept { return _mm256_add_pd(a, b); }
+    static inline reg sub(const reg a, const reg b) noexcept { return _mm256_sub_pd(a, b); }
+    static inline reg mul(const reg a, const reg b) noexcept { return _mm256_mul_pd(a, b); }
+    static inline reg div(const reg a, const reg b) noexcept { return _mm256_div_pd(a, b); }
+    static inline reg sqrt(const reg a) noexcept { return _mm256_sqrt_pd(a); }
+    static inline reg fmadd(const reg a, const reg b, const reg c) noexcept { return _mm256_fmadd_pd(a, b, c); }
+    static inline reg fmsub(const reg a, const reg b, const reg c) noexcept { return _mm256_fmsub_pd(a, b, c); }
+};
+template <>
+struct __simd<float> {
+    using type = float;
+    using reg = __m256;
+    using tail = __simd_scalar<float, true>;
+    static constexpr std::size_t width = 8;
+
+    static inline reg set1(const float a) noexcept { return _mm256_set1_ps(a); }
+    static inline reg load(const float* p) noexcept { return _mm256_loadu_ps(p); }
+    static inline void store(float* p, const reg a) noexcept { _mm256_storeu_ps(p, a); }
+    static inline reg __halves(const float* a, const float* b) noexcept {
+        return _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(a)), _mm_loadu_ps(b), 1);
+    }
+    static inline void __store_halves(float* a, float* b, const reg r) noexcept {
+        _mm_storeu_ps(a, _mm256_castps256_ps128(r));
+        _mm_storeu_ps(b, _mm256_extractf128_ps(r, 1));
+    }
+    // Elements 0 to 3 in the low lanes and 4 to 7 in the high ones, then the shuffles of SSE on each lane
+    template <std::size_t D>
+    static inline void load_aos(const float* p, reg (&r)[D]) noexcept {
+        if constexpr (D == 2) {
+            const reg a = __halves(p, p + 8), b = __halves(p + 4, p + 12);
+            r[0] = _mm256_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0));
+            r[1] = _mm256_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1));
+        }
+        else {
+            const reg a = __halves(p, p + 12), b = __halves(p + 4, p + 16), c = __halves(p + 8, p + 20);
+            r[0] = _mm256_shuffle_ps(a, _mm256_shuffle_ps(b, c, _MM_SHUFFLE(1, 0, 3, 2)), _MM_SHUFFLE(3, 0, 3, 0));
+            r[1] = _mm256_shuffle_ps(_mm256_shuffle_ps(a, b, _MM_SHUFFLE(0, 0, 1, 1)), _mm256_shuffle_ps(b, c, _MM_SHUFFLE(2, 2, 3, 3)), _MM_SHUFFLE(2, 0, 2, 0));
+            r[2] = _mm256_shuffle_ps(_mm256_shuffle_ps(a, b, _MM_SHUFFLE(1, 1, 2, 2)), _mm256_shuffle_ps(c, c, _MM_SHUFFLE(3, 3, 0, 0)), _MM_SHUFFLE(2, 0, 2, 0));
+        }
+    }
+    template <std::size_t D>
+    static inline void store_aos(float* p, const reg (&r)[D]) noexcept {
+        if constexpr (D == 2) {
+            __store_halves(p, p + 8, _mm256_unpacklo_ps(r[0], r[1]));
+            __store_halves(p + 4, p + 12, _mm256_unpackhi_ps(r[0], r[1]));
+        }
+        else {
+            const reg x = r[0], y = r[1], z = r[2];
+            __store_halves(p, p + 12, _mm256_shuffle_ps(_mm256_shuffle_ps(x, y, _MM_SHUFFLE(0, 0, 0, 0)), _mm256_shuffle_ps(z, x, _MM_SHUFFLE(1, 1, 0, 0)), _MM_SHUFFLE(2, 0, 2, 0)));
+            __store_halves(p + 4, p + 16, _mm256_shuffle_ps(_mm256_shuffle_ps(y, z, _MM_SHUFFLE(1, 1, 1, 1)), _mm256_shuffle_ps(x, y, _MM_SHUFFLE(2, 2, 2, 2)), _MM_SHUFFLE(2, 0, 2, 0)));
+            __store_halves(p + 8, p + 20, _mm256_shuffle_ps(_mm256_shuffle_ps(z, x, _MM_SHUFFLE(3, 3, 2, 2)), _mm256_shuffle_ps(y, z, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(2, 0, 2, 0)));
+        }
+    }
+    static inline reg add(const reg a, const reg b) noexcept { return _mm256_add_ps(a, b); }
+    static inline reg sub(const reg a, const reg b) noexcept { return _mm256_sub_ps(a, b); }
+    static inline reg mul(const reg a, const reg b) noexcept { return _mm256_mul_ps(a, b); }
+    static inline reg div(const reg a, const reg b) noexcept { return _mm256_div_ps(a, b); }
+    static inline reg sqrt(const reg a) noexcept { return _mm256_sqrt_ps(a); }
+    static inline reg fmadd(const reg a, const reg b, const reg c) noexcept { return _mm256_fmadd_ps(a, b, c); }
+    static inline reg fmsub(const reg a, const reg b, const reg c) noexcept { return _mm256_fmsub_ps(a, b, c); }
+};
+}
+#if defined(__clang__)
+#pragma clang attribute pop
+#else
+#pragma GCC pop_options
+#endif
+// AVX-512: 8 doubles or 16 floats per register
+#if defined(__clang__)
+#pragma clang attribute push(__attribute__((target("avx512f,avx2,fma"))), apply_to = function)
+#else
+#pragma GCC push_options
+#pragma GCC target("avx512f,avx2,fma")
+// GCC 12 warns about _mm512_undefined_pd() inside its own intrinsics
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#endif
+namespace __isa_avx512 {
+#include "vector_simd_kernels.inc"
+// Indices of two-source permutes that transpose W elements of D components, stored one after the other.
+// Loading component c takes value j D + c of the first two registers, then of the third one.
+// Storing register k takes every component from its register, the first two then the third one.
+template <typename I, std::size_t W, std::size_t D>
+struct __aos_index {
+    alignas(64) I load[2][D][W];
+    alignas(64) I store[2][D][W];
+    constexpr __aos_index() : load(), store() {
+        for (std::size_t c = 0; c < D; ++c)
+            for (std::size_t j = 0; j < W; ++j) {
+                const std::size_t e = j * D + c;
+                load[0][c][j] = I(e < 2 * W ? e : 0);
+                load[1][c][j] = I(e < 2 * W ? j : W + e - 2 * W);
+            }
+        for (std::size_t k = 0; k < D; ++k)
+            for (std::size_t j = 0; j < W; ++j) {
+                const std::size_t q = k * W + j, c = q % D, e = q / D;
+                store[0][k][j] = I(c == 0 ? e : c == 1 ? W + e : 0);
+                store[1][k][j] = I(c == 2 ? W + e : j);
+            }
+    }
+};
+template <typename I, std::size_t W, std::size_t D>
+inline constexpr __aos_index<I, W, D> __aos_indices;
+template <std::floating_point T>
+struct __simd;
+template <>
+struct __simd<double> {
+    using type = double;
+    using reg = __m512d;
+    using tail = __simd_scalar<double, true>;
+    static constexpr std::size_t width = 8;
+
+    static inline reg set1(const double a) noexcept { return _mm512_set1_pd(a); }
+    static inline reg load(const double* p) noexcept { return _mm512_loadu_pd(p); }
+    static inline void store(double* p, const reg a) noexcept { _mm512_storeu_pd(p, a); }
+    template <std::size_t D>
+    static inline void load_aos(const double* p, reg (&r)[D]) noexcept {
+        constexpr const auto &I = __aos_indices<long long, width, D>;
+        const reg a = _mm512_loadu_pd(p), b = _mm512_loadu_pd(p + width);
+        for (std::size_t c = 0; c < D; ++c) {
+            r[c] = _mm512_permutex2var_pd(a, _mm512_load_si512(I.load[0][c]), b);
+            if constexpr (D == 3) r[c] = _mm512_permutex2var_pd(r[c], _mm512_load_si512(I.load[1][c]), _mm512_loadu_pd(p + 2 * width));
+        }
+    }
+    template <std::size_t D>
+    static inline void store_aos(double* p, const reg (&r)[D]) noexcept {
+        constexpr const auto &I = __aos_indices<long long, width, D>;
+        for (std::size_t k = 0; k < D; ++k) {
+            reg a = _mm512_permutex2var_pd(r[0], _mm512_load_si512(I.store[0][k]), r[1]);
+            if constexpr (D == 3) a = _mm512_permutex2var_pd(a, _mm512_load_si512(I.store[1][k]), r[2]);
+            _mm512_storeu_pd(p + k * width, a);
+        }
+    }
+    static inline reg add(const reg a, const reg b) noexcept { return _mm512_add_pd(a, b); }
+    static inline reg sub(const reg a, const reg b) noexcept { return _mm512_sub_pd(a, b); }
+    static inline reg mul(const reg a, const reg b) noexcept { return _mm512_mul_pd(a, b); }
+    static inline reg div(const reg a, const reg b) noexcept { return _mm512_div_pd(a, b); }
+    static inline reg sqrt(const reg a) noexcept { return _mm512_sqrt_pd(a); }
+    static inline reg fmadd(const reg a, const reg b, const reg c) noexcept { return _mm512_fmadd_pd(a, b, c); }
+    static inline reg fmsub(const reg a, const reg b, const reg c) noexcept { return _mm512_fmsub_pd(a, b, c); }
+};
+template <>
+struct __simd<float> {
+    using type = float;
+    using reg = __m512;
+    using tail = __simd_scalar<float, true>;
+    static constexpr std::size_t width = 16;
+
+    static inline reg set1(const float a) noexcept { return _mm512_set1_ps(a); }
+    static inline reg load(const float* p) noexcept { return _mm512_loadu_ps(p); }
+    static inline void store(float* p, const reg a) noexcept { _mm512_storeu_ps(p, a); }
+    template <std::size_t D>
+    static inline void load_aos(const float* p, reg (&r)[D]) noexcept {
+        constexpr const auto &I = __aos_indices<int, width, D>;
+        const reg a = _mm512_loadu_ps(p), b = _mm512_loadu_ps(p + width);
+        for (std::size_t c = 0; c < D; ++c) {
+            r[c] = _mm512_permutex2var_ps(a, _mm512_load_si512(I.load[0][c]), b);
+            if constexpr (D == 3) r[c] = _mm512_permutex2var_ps(r[c], _mm512_load_si512(I.load[1][c]), _mm512_loadu_ps(p + 2 * width));
+        }
+    }
+    template <std::size_t D>
+    static inline void store_aos(float* p, const reg (&r)[D]) noexcept {
+        constexpr const auto &I = __aos_indices<int, width, D>;
+        for (std::size_t k = 0; k < D; ++k) {
+            reg a = _mm512_permutex2var_ps(r[0], _mm512_load_si512(I.store[0][k]), r[1]);
+            if constexpr (D == 3) a = _mm512_permutex2var_ps(a, _mm512_load_si512(I.store[1][k]), r[2]);
+            _mm512_storeu_ps(p + k * width, a);
+        }
+    }
+    static inline reg add(const reg a, const reg b) noexcept { return _mm512_add_ps(a, b); }
+    static inline reg sub(const reg a, const reg b) noexcept { return _mm512_sub_ps(a, b); }
+    static inline reg mul(const reg a, const reg b) noexcept { return _mm512_mul_ps(a, b); }
+    static inline reg div(const reg a, const reg b) noexcept { return _mm512_div_ps(a, b); }
+    static inline reg sqrt(const reg a) noexcept { return _mm512_sqrt_ps(a); }
+    static inline reg fmadd(const reg a, const reg b, const reg c) noexcept { return _mm512_fmadd_ps(a, b, c); }
+    static inline reg fmsub(const reg a, const reg b, const reg c) noexcept { return _mm512_fmsub_ps(a, b, c); }
+};
+}
+#if defined(__clang__)
+#pragma clang attribute pop
+#else
+#pragma GCC diagnostic pop
+#pragma GCC pop_options
+#endif
+#endif
+/*
+*  Instruction set selection
+*/
+enum class simd_isa { scalar, sse42, avx2, avx512 };
+inline constexpr const char* simd_isa_name(const simd_isa isa) noexcept {
+    switch (isa) {
+    case simd_isa::sse42: return "sse4.2";
+    case simd_isa::avx2: return "avx2";
+    case simd_isa::avx512: return "avx512";
+    default: return "scalar";
+    }
+}
+// Whether this CPU (and OS) can run the kernels of an instruction set
+inline bool simd_isa_supported(const simd_isa isa) noexcept {
+#ifdef __VECTOR3D_X86_DISPATCH
+    __builtin_cpu_init();
+    const bool avx2 = __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+    switch (isa) {
+    case simd_isa::sse42: return __builtin_cpu_supports("sse4.2");
+    case simd_isa::avx2: return avx2;
+    case simd_isa::avx512: return avx2 && __builtin_cpu_supports("avx512f");
+    default: return true;
+    }
+#else
+    return isa == simd_isa::scalar;
+#endif
+}
+// Best supported instruction set, or the one requested in VECTOR3D_ISA if the CPU supports it
+inline simd_isa __detect_isa() noexcept {
+    const simd_isa all[] = {simd_isa::scalar, simd_isa::sse42, simd_isa::avx2, simd_isa::avx512};
+    simd_isa best = simd_isa::scalar;
+    for (const simd_isa isa : all)
+        if (simd_isa_supported(isa))
+            best = isa;
+    if (const char* env = std::getenv("VECTOR3D_ISA"))
+        for (const simd_isa isa : all)
+            if (std::strcmp(env, simd_isa_name(isa)) == 0 && simd_isa_supported(isa))
+                return isa;
+    return best;
+}
+inline std::atomic<simd_isa>& __active_isa() noexcept {
+    static std::atomic<simd_isa> isa(__detect_isa());
+    return isa;
+}
+// Instruction set used by the batch kernels
+inline simd_isa batch_isa() noexcept {
+    return __active_isa().load(std::memory_order_relaxed);
+}
+// Switch the instruction set used by the batch kernels. Returns false, and changes nothing, if the CPU does not support it.
+inline bool set_batch_isa(const simd_isa isa) noexcept {
+    if (!simd_isa_supported(isa))
+        return false;
+    __active_isa().store(isa, std::memory_order_relaxed);
+    return true;
+}
+// Other floating point types, e.g. long double, always use the portable kernels.
+template <typename T>
+static constexpr bool __simd_type_v = std::is_same_v<T, float> || std::is_same_v<T, double>;
+template <std::floating_point T>
+inline const __batch_table<T>& __kernels() noexcept {
+#ifdef __VECTOR3D_X86_DISPATCH
+    if constexpr (__simd_type_v<T>) {
+        switch (batch_isa()) {
+        case simd_isa::avx512: return __isa_avx512::__table<__isa_avx512::__simd<T>>;
+        case simd_isa::avx2: return __isa_avx2::__table<__isa_avx2::__simd<T>>;
+        case simd_isa::sse42: return __isa_sse42::__table<__isa_sse42::__simd<T>>;
+        default: break;
+        }
+    }
+#endif
+    return __isa_scalar::__table<__isa_scalar::__simd<T>>;
+}
+/*
+*  Public interface
+*  Arrays of vectors are passed as a pointer and the number of elements, e.g. batch_dot(u.data(), v.data(), out.data(), u.size()).
+*  Results may differ from the scalar operators in the last bit, the AVX kernels use fused multiply-add.
+*  The vector3DArray overloads throw std::length_error if the operands differ in size, and resize the output array.
+*/
+// Component pointers of arrays of structs and of vector3DArray
+template <std::floating_point T>
+inline constexpr std::array<const T*, 3> __components(const vector3D<T>* v) noexcept {
+    const T* p = reinterpret_cast<const T*>(v);
+    return {p, p + 1, p + 2};
+}
+template <std::floating_point T>
+inline constexpr std::array<T*, 3> __components(vector3D<T>* v) noexcept {
+    T* p = reinterpret_cast<T*>(v);
+    return {p, p + 1, p + 2};
+}
+template <std::floating_point T>
+inline constexpr std::array<const T*, 2> __components(const vector2D<T>* v) noexcept {
+    const T* p = reinterpret_cast<const T*>(v);
+    return {p, p + 1};
+}
+template <std::floating_point T>
+inline constexpr std::array<T*, 2> __components(vector2D<T>* v) noexcept {
+    T* p = reinterpret_cast<T*>(v);
+    return {p, p + 1};
+}
+template <std::floating_point T>
+inline constexpr std::array<const T*, 3> __components(const vector3DArray<T>& v) noexcept {
+    return {v.x(), v.y(), v.z()};
+}
+template <std::floating_point T>
+inline constexpr std::array<T*, 3> __components(vector3DArray<T>& v) noexcept {
+    return {v.x(), v.y(), v.z()};
+}
+// Dot product: out[i] = u[i] * v[i]
+// The output array takes the size of the operands, like vector3DArray::operator=
+template <std::floating_point T>
+inline void __fit(vector3DArray<T>& out, const std::size_t n) {
+    if (out.size() != n) vector3DArray<T>(n).swap(out);
+}
+template <std::floating_point T>
+inline void batch_dot(const vector3D<T>* u, const vector3D<T>* v, T* out, const std::size_t n) noexcept {
+    __kernels<T>().dot[__aos3D](__components(u).data(), __components(v).data(), out, n);
+}
+template <std::floating_point T>
+inline void batch_dot(const vector2D<T>* u, const vector2D<T>* v, T* out, const std::size_t n) noexcept {
+    __kernels<T>().dot[__aos2D](__components(u).data(), __components(v).data(), out, n);
+}
+template <std::floating_point T>
+inline void batch_dot(const vector3DArray<T>& u, const vector3DArray<T>& v, T* out) {
+    __check_sizes(u, v);
+    __kernels<T>().dot[__soa3D](__components(u).data(), __components(v).data(), out, u.size());
+}
+// Cross product: out[i] = u[i] ^ v[i]. For vector2D the result is a scalar.
+template <std::floating_point T>
+inline void batch_cross(const vector3D<T>* u, const vector3D<T>* v, vector3D<T>* out, const std::size_t n) noexcept {
+    __kernels<T>().cross[__aos3D](__components(u).data(), __components(v).data(), __components(out).data(), n);
+}
+template <std::floating_point T>
+inline void batch_cross(const vector2D<T>* u, const vector2D<T>* v, T* out, const std::size_t n) noexcept {
+    T* o[1] = {out};
+    __kernels<T>().cross[__aos2D](__components(u).data(), __components(v).data(), o, n);
+}
+template <std::floating_point T>
+inline void batch_cross(const vector3DArray<T>& u, const vector3DArray<T>& v, vector3DArray<T>& out) {
+    __check_sizes(u, v);
+    __fit(out, u.size());
+    __kernels<T>().cross[__soa3D](__components(u).data(), __components(v).data(), __components(out).data(), u.size());
+}
+// Square norm: out[i] = norm2(u[i])
+template <std::floating_point T>
+inline void batch_norm2(const vector3D<T>* u, T* out, const std::size_t n) noexcept {
+    __kernels<T>().norm2[__aos3D](__components(u).data(), out, n, false);
+}
+template <std::floating_point T>
+inline void batch_norm2(const vector2D<T>* u, T* out, const std::size_t n) noexcept {
+    __kernels<T>().norm2[__aos2D](__components(u).data(), out, n, false);
+}
+template <std::floating_point T>
+inline void batch_norm2(const vector3DArray<T>& u, T* out) noexcept {
+    __kernels<T>().norm2[__soa3D](__components(u).data(), out, u.size(), false);
+}
+// Norm: out[i] = norm(u[i])
+template <std::floating_point T>
+inline void batch_norm(const vector3D<T>* u, T* out, const std::size_t n) noexcept {
+    __kernels<T>().norm2[__aos3D](__components(u).data(), out, n, true);
+}
+template <std::floating_point T>
+inline void batch_norm(const vector2D<T>* u, T* out, const std::size_t n) noexcept {
+    __kernels<T>().norm2[__aos2D](__components(u).data(), out, n, true);
+}
+template <std::floating_point T>
+inline void batch_norm(const vector3DArray<T>& u, T* out) noexcept {
+    __kernels<T>().norm2[__soa3D](__components(u).data(), out, u.size(), true);
+}
+// Unit vectors: out[i] = unit(u[i]). out can be u.
+template <std::floating_point T>
+inline void batch_unit(const vector3D<T>* u, vector3D<T>* out, const std::size_t n) noexcept {
+    __kernels<T>().unit[__aos3D](__components(u).data(), __components(out).data(), n);
+}
+template <std::floating_point T>
+inline void batch_unit(const vector2D<T>* u, vector2D<T>* out, const std::size_t n) noexcept {
+    __kernels<T>().unit[__aos2D](__components(u).data(), __components(out).data(), n);
+}
+template <std::floating_point T>
+inline void batch_unit(const vector3DArray<T>& u, vector3DArray<T>& out) {
+    __fit(out, u.size());
+    __kernels<T>().unit[__soa3D](__components(u).data(), __components(out).data(), u.size());
+}
+// Scalar multiply-add: y[i] += a * x[i]
+template <std::floating_point T>
+inline void batch_axpy(const T a, const vector3D<T>* x, vector3D<T>* y, const std::size_t n) noexcept {
+    __kernels<T>().axpy(a, __components(x)[0], __components(y)[0], 3 * n);
+}
+template <std::floating_point T>
+inline void batch_axpy(const T a, const vector2D<T>* x, vector2D<T>* y, const std::size_t n) noexcept {
+    __kernels<T>().axpy(a, __components(x)[0], __components(y)[0], 2 * n);
+}
+template <std::floating_point T>
+inline void batch_axpy(const T a, const vector3DArray<T>& x, vector3DArray<T>& y) {
+    __check_sizes(x, y);
+    __kernels<T>().axpy(a, x.x(), y.x(), x.size());
+    __kernels<T>().axpy(a, x.y(), y.y(), x.size());
+    __kernels<T>().axpy(a, x.z(), y.z(), x.size());
+}
+// Angle in radians: out[i] = angle(u[i], v[i])
+template <std::floating_point T>
+inline void batch_angle(const vector3D<T>* u, const vector3D<T>* v, T* out, const std::size_t n) noexcept {
+    __kernels<T>().angle[__aos3D](__components(u).data(), __components(v).data(), out, n);
+}
+template <std::floating_point T>
+inline void batch_angle(const vector2D<T>* u, const vector2D<T>* v, T* out, const std::size_t n) noexcept {
+    __kernels<T>().angle[__aos2D](__components(u).data(), __components(v).data(), out, n);
+}
+template <std::floating_point T>
+inline void batch_angle(const vector3DArray<T>& u, const vector3DArray<T>& v, T* out) {
+    __check_sizes(u, v);
+    __kernels<T>().angle[__soa3D](__components(u).data(), __components(v).data(), out, u.size());
+}
@@ -0,0 +1,664 @@
+#pragma once
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <exception>
+#include <fstream>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <thread>
+#include <type_traits>
+#include <vector>
+#include "vector_array.h"
+
+/*
+ * This file is part of the Vector3D distribution (https://github.com/cdelv/Vector3D).
+ * Copyright (c) 2022 Carlos Andres del Valle.
+ *
+ * Vector3D is under the terms of the BSD-3 license. We welcome feedback and contributions.
+ *
+ * you should have received a copy of the BSD3 Public License
+ * along with this program. If not, see <https://github.com/cdelv/Vector3D> LICENSE.
+ *
+ *
+ * This library requires C++20.
+*/
+
+/*
+*  Text files of vectors: one vector per line, with the components separated by spaces, tabs, or a comma
+*  (XYZ and CSV), optionally in parentheses as operator<< prints them. Numbers are read with std::from_chars, which doesn't allocate, doesn't look at the
+*  locale, and is many times faster than operator>>. Files are read in chunks that end on a line break,
+*  and each chunk can be split between several threads. Empty lines and lines starting with # are skipped.
+*  Writing is the other way around: std::to_chars formats whole arrays into a buffer that goes to the
+*  file in large unbuffered writes.
+*/
+struct text_options {
+    std::size_t header_lines = 0;       // lines skipped at the start, e.g. 1 for a CSV header, 2 for XYZ
+    std::size_t skip_columns = 0;       // fields skipped at the start of every line, e.g. 1 for the element of XYZ
+    std::size_t threads = 1;            // 0 for one per hardware thread
+    std::size_t chunk_bytes = 16 << 20; // read from the file at a time
+};
+
+// A malformed line. line and column count from 1, column in bytes.
+struct text_error {
+    std::size_t line = 0;
+    std::size_t column = 0;
+    std::string message;
+    std::string text;                   // the line, cut at 80 characters
+};
+
+class vector_parse_error : public std::runtime_error {
+public:
+    text_error error;
+    vector_parse_error(const std::string &source, const text_error &e)
+        : std::runtime_error(source + ":" + std::to_string(e.line) + ":" + std::to_string(e.column) + ": " + e.message + ": " + e.text), error(e) {}
+};
+
+inline constexpr bool __is_blank(const char c) noexcept {
+    return c == ' ' || c == '\t' || c == '\r';
+}
+inline constexpr const char* __skip_blanks(const char *p, const char *end) noexcept {
+    while (p != end && __is_blank(*p)) ++p;
+    return p;
+}
+
+// Vectors and errors parsed from one piece of a chunk. Lines are counted from the start of the piece.
+template <typename V>
+struct __ParsedText {
+    std::vector<V> vectors;
+    std::vector<text_error> errors;
+    std::size_t lines = 0;
+};
+
+// Parses the lines of text. With stop, it returns at the first malformed line.
+template <typename V>
+inline void __parse_lines(std::string_view text, const text_options &options, const bool stop, __ParsedText<V> &out) {
+    using T = std::remove_cvref_t<decltype(std::declval<V&>()[0])>;
+    constexpr std::size_t N = V::size();
+    const char* p = text.data();
+    const char* const end = p + text.size();
+    while (p != end) {
+        const char* eol = static_cast<const char*>(std::memchr(p, '\n', static_cast<std::size_t>(end - p)));
+        if (!eol) eol = end;
+        const char* const line = p;
+        ++out.lines;
+        const auto fail = [&](const char *at, const char *why) {
+            const std::string_view l(line, static_cast<std::size_t>(eol - line));
+            out.errors.push_back({out.lines, static_cast<std::size_t>(at - line) + 1, why,
+                                  std::string(l.substr(0, std::min<std::size_t>(80, l.find_last_not_of('\r') + 1)))});
+        };
+        p = __skip_blanks(p, eol);
+        if (p == eol || *p == '#') {
+            p = eol == end ? end : eol + 1;
+            continue;
+        }
+        // Leading fields that aren't components
+        bool ok = true;
+        for (std::size_t c = 0; c < options.skip_columns && ok; ++c) {
+            while (p != eol && !__is_blank(*p) && *p != ',') ++p;
+            p = __skip_blanks(p, eol);
+            if (p != eol && *p == ',') p = __skip_blanks(p + 1, eol);
+            if (p == eol) {
+                fail(p, "too few values");
+                ok = false;
+            }
+        }
+        // Written by operator<< or text_format::tuple
+        const bool tuple = ok && *p == '(';
+        if (tuple)
+            p = __skip_blanks(p + 1, eol);
+        V v;
+        for (std::size_t k = 0; k < N && ok; ++k) {
+            if (p == eol) {
+                fail(p, "too few values");
+                ok = false;
+                break;
+            }
+            // from_chars doesn't take an explicit plus sign
+            const char* q = p != eol && *p == '+' ? p + 1 : p;
+            T x{};
+            const auto [r, ec] = std::from_chars(q, eol, x);
+            if (ec == std::errc::result_out_of_range)
+                fail(p, "number out of range");
+            else if (ec != std::errc())
+                fail(p, "expected a number");
+            if (ec != std::errc()) {
+                ok = false;
+                break;
+            }
+            v[k] = x;
+            p = __skip_blanks(r, eol);
+            if (p != eol && *p == ',')
+                p = __skip_blanks(p + 1, eol);
+            else if (p == r && p != eol && !(tuple && *p == ')')) {
+                fail(p, "unexpected character");
+                ok = false;
+            }
+        }
+        if (ok && tuple) {
+            if (p != eol && *p == ')')
+                p = __skip_blanks(p + 1, eol);
+            else {
+                fail(p, p == eol ? "expected )" : "too many values");
+                ok = false;
+            }
+        }
+        if (ok && p != eol) {
+            fail(p, "too many values");
+            ok = false;
+        }
+        if (ok)
+            out.vectors.push_back(v);
+        else if (stop)
+            return;
+        p = eol == end ? end : eol + 1;
+    }
+}
+
+// Parses a chunk that ends on a line break, split between threads at line breaks, and appends the results in order.
+// first_line is the number of lines before the chunk. Returns the number of lines in the chunk.
+template <typename V>
+inline std::size_t __parse_chunk(std::string_view chunk, const text_options &options, const std::size_t first_line,
+                                 std::vector<V> &vectors, std::vector<text_error> *errors, const std::string &source) {
+    std::size_t threads = options.threads ? options.threads : std::max(1u, std::thread::hardware_concurrency());
+    // Pieces smaller than this aren't worth a thread
+    threads = std::min<std::size_t>(threads, chunk.size() / (256 << 10) + 1);
+    std::vector<__ParsedText<V>> parsed(threads);
+    std::vector<std::string_view> pieces;
+    for (std::size_t t = 0, start = 0; t < threads; ++t) {
+        std::size_t stop = t + 1 == threads ? chunk.size() : std::max(start, chunk.size() * (t + 1) / threads);
+        stop = stop < chunk.size() ? chunk.find('\n', stop) : chunk.size();
+        stop = stop == std::string_view::npos ? chunk.size() : stop + (stop < chunk.size());
+        pieces.push_back(chunk.substr(start, stop - start));
+        start = stop;
+    }
+    if (threads == 1) {
+        // Straight into the output
+        parsed[0].vectors = std::move(vectors);
+        __parse_lines(pieces[0], options, !errors, parsed[0]);
+        vectors = std::move(parsed[0].vectors);
+    }
+    else {
+        std::vector<std::thread> workers;
+        for (std::size_t t = 1; t < threads; ++t)
+            workers.emplace_back([&, t] { __parse_lines(pieces[t], options, !errors, parsed[t]); });
+        __parse_lines(pieces[0], options, !errors, parsed[0]);
+        for (std::thread &w : workers)
+            w.join();
+    }
+    std::size_t lines = first_line;
+    for (std::size_t t = 0; t < threads; ++t) {
+        for (text_error &e : parsed[t].errors) {
+            e.line += lines;
+            if (!errors)
+                throw vector_parse_error(source, e);
+            errors->push_back(std::move(e));
+        }
+        if (threads > 1)
+            vectors.insert(vectors.end(), parsed[t].vectors.begin(), parsed[t].vectors.end());
+        lines += parsed[t].lines;
+    }
+    return lines - first_line;
+}
+
+// Removes up to count lines from the start of text and counts them in line. A last line without a line break
+// is removed only if complete is set, since the rest of it may be in the next chunk.
+inline void __skip_lines(std::string_view &text, std::size_t &count, std::size_t &line, const bool complete) noexcept {
+    for (; count > 0 && !text.empty(); --count, ++line) {
+        const std::size_t eol = text.find('\n');
+        if (eol == std::string_view::npos && !complete)
+            return;
+        text.remove_prefix(eol == std::string_view::npos ? text.size() : eol + 1);
+    }
+}
+
+/*
+*  Vectors (vector2D, vector3D or vectorND) from text. A malformed line throws vector_parse_error, with its
+*  line and column. Given errors, malformed lines are skipped instead and listed there, in file order.
+*/
+template <typename V>
+inline std::vector<V> parse_vectors(std::string_view text, const text_options &options = text_options(), std::vector<text_error> *errors = nullptr) {
+    static_assert(std::is_arithmetic_v<std::remove_cvref_t<decltype(std::declval<V&>()[0])>>, "parse_vectors: components must be real numbers");
+    std::vector<V> vectors;
+    std::size_t skip = options.header_lines, line = 0;
+    __skip_lines(text, skip, line, true);
+    __parse_chunk(text, options, line, vectors, errors, "<text>");
+    return vectors;
+}
+template <typename V>
+inline std::vector<V> read_vectors(const std::string &path, const text_options &options = text_options(), std::vector<text_error> *errors = nullptr) {
+    static_assert(std::is_arithmetic_v<std::remove_cvref_t<decltype(std::declval<V&>()[0])>>, "read_vectors: components must be real numbers");
+    std::ifstream file(path, std::ios::binary);
+    if (!file)
+        throw std::runtime_error("vector text: cannot open " + path);
+    const std::size_t chunk = std::max<std::size_t>(options.chunk_bytes, 1);
+    std::vector<V> vectors;
+    std::string buffer;
+    std::size_t skip = options.header_lines, line = 0;
+    for (bool last = false; !last;) {
+        // The buffer starts with the incomplete last line of the previous chunk
+        const std::size_t kept = buffer.size();
+        buffer.resize(kept + chunk);
+        file.read(buffer.data() + kept, static_cast<std::streamsize>(chunk));
+        buffer.resize(kept + static_cast<std::size_t>(file.gcount()));
+        last = !file;
+        if (file.bad())
+            throw std::runtime_error("vector text: cannot read " + path);
+        std::string_view text(buffer);
+        __skip_lines(text, skip, line, last);
+        const std::size_t eol = text.rfind('\n');
+        if (!last && (skip > 0 || eol == std::string_view::npos)) {
+            buffer.erase(0, buffer.size() - text.size());
+            continue;
+        }
+        const std::string_view lines = last ? text : text.substr(0, eol + 1);
+        line += __parse_chunk(lines, options, line, vectors, errors, path);
+        buffer.erase(0, buffer.size() - text.size() + lines.size());
+    }
+    return vectors;
+}
+
+/*
+*  Writing. Every line is one vector:
+*    xyz    element x y z, after a line with the number of vectors and a comment line. Every write is a frame,
+*           so a file of frames is an XYZ trajectory.
+*    csv    x,y,z, after a header line with the names of the components
+*    plain  x y z
+*    tuple  (x, y, z), like operator<<
+*/
+enum class text_format { xyz, csv, plain, tuple };
+
+struct format_options {
+    text_format format = text_format::plain;
+    int precision = -1;                 // significant digits, -1 for the shortest that reads back the same number
+    std::string separator;              // between components, empty for " ", ",", or ", " by format
+    std::string element = "X";          // xyz: the first column
+    std::string comment;                // xyz: the second line of every frame
+    bool header = true;                 // csv: write the header line
+    std::size_t buffer_bytes = 4 << 20; // formatted before every write to the file
+};
+
+inline std::string_view __separator(const format_options &options) noexcept {
+    if (!options.separator.empty())
+        return options.separator;
+    return options.format == text_format::csv ? "," : options.format == text_format::tuple ? ", " : " ";
+}
+
+/*
+*  Formats vectors into a reusable buffer and hands it to sink(data, bytes) whenever the next line might
+*  not fit. Lines are formatted in place: the buffer keeps room for the longest line a vector can take.
+*/
+class __TextFormatter {
+    std::vector<char> _buffer;
+    std::size_t _used = 0;
+public:
+    explicit __TextFormatter(const std::size_t bytes) : _buffer(std::max<std::size_t>(bytes, 4096)) {}
+
+    template <typename Sink>
+    inline void flush(Sink &&sink) {
+        if (_used > 0)
+            sink(_buffer.data(), _used);
+        _used = 0;
+    }
+    template <typename Sink>
+    inline void append(std::string_view text, Sink &&sink) {
+        while (!text.empty()) {
+            if (_used == _buffer.size())
+                flush(sink);
+            const std::size_t m = std::min(text.size(), _buffer.size() - _used);
+            std::memcpy(_buffer.data() + _used, text.data(), m);
+            _used += m;
+            text.remove_prefix(m);
+        }
+    }
+    // get(i, k) is component k of vector i
+    template <typename T, std::size_t N, typename Get, typename Sink>
+    inline void vectors(const std::size_t n, Get &&get, const format_options &options, Sink &&sink) {
+        static_assert(std::is_arithmetic_v<T>, "vector text: components must be real numbers");
+        const std::string_view sep = __separator(options);
+        const bool xyz = options.format == text_format::xyz, tuple = options.format == text_format::tuple;
+        // Longest number: digits, sign, point, and exponent
+        const std::size_t number = std::is_floating_point_v<T> ? static_cast<std::size_t>(std::max(options.precision, 17)) + 16 : 24;
+        const std::size_t line = N * (number + sep.size()) + (xyz ? options.element.size() + 1 : 0) + 3;
+        if (line > _buffer.size())
+            _buffer.resize(line);
+        for (std::size_t i = 0; i < n; ++i) {
+            if (_buffer.size() - _used < line)
+                flush(sink);
+            char* p = _buffer.data() + _used;
+            char* const end = _buffer.data() + _buffer.size();
+            if (xyz) {
+                p = std::copy(options.element.begin(), options.element.end(), p);
+                *p++ = ' ';
+            }
+            if (tuple)
+                *p++ = '(';
+            for (std::size_t k = 0; k < N; ++k) {
+                if (k > 0)
+                    p = std::copy(sep.begin(), sep.end(), p);
+                const T x = get(i, k);
+                if constexpr (std::is_floating_point_v<T>)
+                    p = (options.precision < 0 ? std::to_chars(p, end, x) : std::to_chars(p, end, x, std::chars_format::general, options.precision)).ptr;
+                else
+                    p = std::to_chars(p, end, x).ptr;
+            }
+            if (tuple)
+                *p++ = ')';
+            *p++ = '\n';
+            _used = static_cast<std::size_t>(p - _buffer.data());
+        }
+    }
+    // The lines in front of the vectors: the xyz frame header, or the csv header if first
+    template <std::size_t N, typename Sink>
+    inline void header(const std::size_t n, const format_options &options, const bool first, Sink &&sink) {
+        if (options.format == text_format::xyz) {
+            append(std::to_string(n) + "\n", sink);
+            append(options.comment.substr(0, options.comment.find('\n')) + "\n", sink);
+        }
+        else if (options.format == text_format::csv && options.header && first) {
+            std::string names;
+            for (std::size_t k = 0; k < N; ++k) {
+                if (k > 0)
+                    names += __separator(options);
+                names += N <= 3 ? std::string(1, "xyz"[k]) : "c" + std::to_string(k);
+            }
+            append(names + "\n", sink);
+        }
+    }
+};
+
+/*
+*  Writes arrays of vectors to a text file. The file isn't buffered by the C library: the formatted
+*  buffer, a few MiB, goes out in one write. Closing or destroying the writer writes what is left.
+*/
+class vector_writer {
+    std::FILE* _file = nullptr;
+    std::string _path;
+    format_options _options;
+    __TextFormatter _formatter;
+    bool _first = true;
+
+    inline auto __sink() {
+        return [this](const char *data, const std::size_t bytes) {
+            if (std::fwrite(data, 1, bytes, _file) != bytes)
+                throw std::runtime_error("vector text: cannot write " + _path);
+        };
+    }
+    template <typename T, std::size_t N, typename Get>
+    inline void __write(const std::size_t n, Get &&get) {
+        if (!_file)
+            throw std::runtime_error("vector text: " + _path + " is closed");
+        _formatter.header<N>(n, _options, _first, __sink());
+        _formatter.vectors<T, N>(n, get, _options, __sink());
+        _first = false;
+    }
+public:
+    explicit vector_writer(const std::string &path, const format_options &options = format_options(), const bool append = false)
+        : _file(std::fopen(path.c_str(), append ? "ab" : "wb")), _path(path), _options(options), _formatter(options.buffer_bytes) {
+        if (!_file)
+            throw std::runtime_error("vector text: cannot open " + path);
+        std::setvbuf(_file, nullptr, _IONBF, 0);
+        // Appended frames continue the file: the CSV header is only written to an empty one
+        if (append) {
+            std::fseek(_file, 0, SEEK_END);
+            _first = std::ftell(_file) == 0;
+        }
+    }
+    vector_writer(const vector_writer&) = delete;
+    vector_writer& operator=(const vector_writer&) = delete;
+    ~vector_writer() {
+        try {
+            close();
+        }
+        catch (const std::runtime_error&) {
+        }
+    }
+
+    // vector2D, vector3D or vectorND
+    template <typename V>
+    inline void write(const V *vectors, const std::size_t n) {
+        using T = std::remove_cvref_t<decltype(std::declval<const V&>()[0])>;
+        __write<T, V::size()>(n, [vectors](const std::size_t i, const std::size_t k) { return vectors[i][k]; });
+    }
+    template <typename V>
+    inline void write(const std::vector<V> &vectors) {
+        write(vectors.data(), vectors.size());
+    }
+    template <typename T>
+    inline void write(const vector3DArray<T> &vectors) {
+        const T* c[3] = {vectors.x(), vectors.y(), vectors.z()};
+        __write<T, 3>(vectors.size(), [&c](const std::size_t i, const std::size_t k) { return c[k][i]; });
+    }
+    // Writes what is in the buffer
+    inline void flush() {
+        if (!_file)
+            return;
+        _formatter.flush(__sink());
+        std::fflush(_file);
+    }
+    inline void close() {
+        if (!_file)
+            return;
+        bool failed = false;
+        try {
+            _formatter.flush(__sink());
+        }
+        catch (const std::runtime_error&) {
+            failed = true;
+        }
+        failed = std::fclose(_file) != 0 || failed;
+        _file = nullptr;
+        if (failed)
+            throw std::runtime_error("vector text: cannot write " + _path);
+    }
+};
+
+// The text of vectors as vector_writer writes it
+template <typename V>
+inline std::string format_vectors(const std::vector<V> &vectors, const format_options &options = format_options()) {
+    using T = std::remove_cvref_t<decltype(std::declval<const V&>()[0])>;
+    std::string text;
+    const auto sink = [&text](const char *data, const std::size_t bytes) { text.append(data, bytes); };
+    __TextFormatter formatter(std::min<std::size_t>(options.buffer_bytes, 64 << 10));
+    formatter.header<V::size()>(vectors.size(), options, true, sink);
+    formatter.vectors<T, V::size()>(vectors.size(), [&vectors](const std::size_t i, const std::size_t k) { return vectors[i][k]; }, options, sink);
+    formatter.flush(sink);
+    return text;
+}
+
+/*
+*  Writes frames on a background thread, so the simulation doesn't wait for formatting and I/O. write()
+*  copies the frame into a free buffer, or takes a std::vector by move, queues it, and returns. There are
+*  at most capacity frames queued or being written, two by default (double buffering): a write() that
+*  finds them all busy waits for one, and that wait is counted as a stall. An error on the background
+*  thread is thrown by the next write(), flush(), or close(), and later frames are dropped.
+*/
+struct writer_stats {
+    std::size_t frames = 0;                 // formatted into the file buffer, in the file after flush() or close()
+    std::size_t stalls = 0;                 // write() calls that waited for a buffer
+    std::chrono::duration<double> stall_time{0};
+    std::chrono::duration<double> max_stall{0};
+    std::chrono::duration<double> write_time{0};    // on the background thread
+};
+
+template <typename V>
+class async_vector_writer {
+    using clock = std::chrono::steady_clock;
+    vector_writer _out;
+    const std::size_t _capacity;
+    std::size_t _busy = 0;                  // frames queued or being written
+    std::deque<std::vector<V>> _queue;
+    std::vector<std::vector<V>> _free;      // buffers of written frames, reused
+    bool _closing = false;
+    std::exception_ptr _error;
+    writer_stats _stats;
+    mutable std::mutex _mutex;
+    std::condition_variable _queued, _done;
+    std::thread _thread;
+
+    inline void __run() {
+        std::unique_lock<std::mutex> lock(_mutex);
+        while (true) {
+            _queued.wait(lock, [this] { return !_queue.empty() || _closing; });
+            if (_queue.empty())
+                return;
+            std::vector<V> frame = std::move(_queue.front());
+            _queue.pop_front();
+            const bool skip = static_cast<bool>(_error);
+            lock.unlock();
+            const clock::time_point start = clock::now();
+            std::exception_ptr error;
+            try {
+                if (!skip) _out.write(frame);
+            }
+            catch (...) {
+                error = std::current_exception();
+            }
+            const clock::duration time = clock::now() - start;
+            lock.lock();
+            if (error && !_error)
+                _error = error;
+            _stats.frames += !skip && !error;
+            _stats.write_time += time;
+            // Moved in frames add buffers: keep one per slot
+            if (_free.size() < _capacity)
+                _free.push_back(std::move(frame));
+            --_busy;
+            _done.notify_all();
+        }
+    }
+    inline void __rethrow() const {
+        if (_error)
+            std::rethrow_exception(_error);
+    }
+    // A slot for the next frame, after waiting for one if all are busy. Returns with the lock held.
+    inline void __reserve(std::unique_lock<std::mutex> &lock) {
+        if (_closing)
+            throw std::runtime_error("vector text: the writer is closed");
+        __rethrow();
+        if (_busy == _capacity) {
+            const clock::time_point start = clock::now();
+            _done.wait(lock, [this] { return _busy < _capacity; });
+            const std::chrono::duration<double> stall = clock::now() - start;
+            ++_stats.stalls;
+            _stats.stall_time += stall;
+            _stats.max_stall = std::max(_stats.max_stall, stall);
+            __rethrow();
+        }
+        ++_busy;
+    }
+    // A slot and a buffer for the next frame. Returns with the lock held.
+    inline std::vector<V> __acquire(std::unique_lock<std::mutex> &lock) {
+        __reserve(lock);
+        if (_free.empty())
+            return std::vector<V>();
+        std::vector<V> frame = std::move(_free.back());
+        _free.pop_back();
+        return frame;
+    }
+    inline void __queue(std::unique_lock<std::mutex> &lock, std::vector<V> &&frame) {
+        lock.lock();
+        _queue.push_back(std::move(frame));
+        _queued.notify_one();
+    }
+    // Gives back the slot of a frame that won't be queued
+    inline void __release(std::unique_lock<std::mutex> &lock, std::vector<V> &&frame) {
+        lock.lock();
+        if (_free.size() < _capacity)
+            _free.push_back(std::move(frame));
+        --_busy;
+        _done.notify_all();
+    }
+public:
+    explicit async_vector_writer(const std::string &path, const format_options &options = format_options(),
+                                 const std::size_t capacity = 2, const bool append = false)
+        : _out(path, options, append), _capacity(std::max<std::size_t>(capacity, 1)) {
+        _thread = std::thread([this] { __run(); });
+    }
+    async_vector_writer(const async_vector_writer&) = delete;
+    async_vector_writer& operator=(const async_vector_writer&) = delete;
+    ~async_vector_writer() {
+        try {
+            close();
+        }
+        catch (...) {
+        }
+    }
+
+    inline void write(const V *vectors, const std::size_t n) {
+        std::unique_lock<std::mutex> lock(_mutex);
+        std::vector<V> frame = __acquire(lock);
+        // The copy doesn't need the lock: the buffer is already counted as busy
+        lock.unlock();
+        try {
+            frame.assign(vectors, vectors + n);
+        }
+        catch (...) {
+            __release(lock, std::move(frame));
+            throw;
+        }
+        __queue(lock, std::move(frame));
+    }
+    inline void write(const std::vector<V> &vectors) {
+        write(vectors.data(), vectors.size());
+    }
+    // Takes the frame without copying it
+    inline void write(std::vector<V> &&vectors) {
+        std::unique_lock<std::mutex> lock(_mutex);
+        __reserve(lock);
+        lock.unlock();
+        __queue(lock, std::move(vectors));
+    }
+    template <typename T>
+    inline void write(const vector3DArray<T> &vectors) requires std::is_same_v<V, vector3D<T>> {
+        std::unique_lock<std::mutex> lock(_mutex);
+        std::vector<V> frame = __acquire(lock);
+        lock.unlock();
+        try {
+            frame.resize(vectors.size());
+        }
+        catch (...) {
+            __release(lock, std::move(frame));
+            throw;
+        }
+        const T *x = vectors.x(), *y = vectors.y(), *z = vectors.z();
+        for (std::size_t i = 0; i < frame.size(); ++i)
+            frame[i].load(x[i], y[i], z[i]);
+        __queue(lock, std::move(frame));
+    }
+    // Waits until every frame is in the file
+    inline void flush() {
+        std::unique_lock<std::mutex> lock(_mutex);
+        _done.wait(lock, [this] { return _busy == 0; });
+        __rethrow();
+        _out.flush();
+    }
+    inline void close() {
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            if (_closing)
+                return;
+            _closing = true;
+        }
+        _queued.notify_one();
+        _thread.join();
+        try {
+            _out.close();
+        }
+        catch (...) {
+            if (!_error) _error = std::current_exception();
+        }
+        __rethrow();
+    }
+    inline writer_stats stats() const {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return _stats;
+    }
+};